@@ -60,12 +60,14 @@
       'sources+': [
         'src/common/v8synchronizationcontext.cpp',
         'src/common/callbackhelper.cpp',
+        'src/common/nodejsfunccompletion.cpp',
         'src/common/edge.cpp',
         'src/CoreCLREmbedding/coreclrembedding.cpp',
         'src/CoreCLREmbedding/coreclrfunc.cpp',
         'src/CoreCLREmbedding/coreclrnodejsfunc.cpp',
         'src/CoreCLREmbedding/coreclrfuncinvokecontext.cpp',
         'src/CoreCLREmbedding/coreclrnodejsfuncinvokecontext.cpp',
+        'src/CoreCLREmbedding/marshalbuffer.cpp',
         'src/common/utils.cpp',
         'src/CoreCLREmbedding/pal/pal_utils.cpp',
         'src/CoreCLREmbedding/pal/trace.cpp',
@@ -204,6 +206,7 @@
                     'src/common/utils.cpp',
                     'src/common/v8synchronizationcontext.cpp',
                     'src/common/callbackhelper.cpp',
+                    'src/common/nodejsfunccompletion.cpp',
                     'src/common/edge.cpp'
                   ],
                   'include_dirs': [
@@ -167,3 +167,7 @@ exports.func = function(language, options) {
 
     return edge.initializeClrFunc(options);
 };
+
+exports.stats = function () {
+    return edge.getStats();
+};
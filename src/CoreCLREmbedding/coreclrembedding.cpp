@@ -35,7 +35,6 @@ GetFuncFunction getFunc;
 CallFuncFunction callFunc;
 ContinueTaskFunction continueTask;
 FreeHandleFunction freeHandle;
-FreeMarshalDataFunction freeMarshalData;
 CompileFuncFunction compileFunc;
 InitializeFunction initialize;
 
@@ -601,7 +600,6 @@ HRESULT CoreClrEmbedding::Initialize(BOOL debugMode)
     CREATE_DELEGATE("CallFunc", &callFunc);
     CREATE_DELEGATE("ContinueTask", &continueTask);
     CREATE_DELEGATE("FreeHandle", &freeHandle);
-    CREATE_DELEGATE("FreeMarshalData", &freeMarshalData);
     CREATE_DELEGATE("SetCallV8FunctionDelegate", &setCallV8Function);
     CREATE_DELEGATE("CompileFunc", &compileFunc);
 	CREATE_DELEGATE("Initialize", &initialize);
@@ -620,6 +618,13 @@ HRESULT CoreClrEmbedding::Initialize(BOOL debugMode)
 	context.runtimeDirectory = coreClrDirectoryCstr.data();
 	context.applicationDirectory = edgeAppDirCstr.data();
 	context.dependencyManifestFile = dependencyManifestFileCstr.data();
+	context.allocMarshalBlock = AllocMarshalBlock;
+	context.reallocMarshalBlock = ReallocMarshalBlock;
+	context.freeMarshalBlock = FreeMarshalBlock;
+	context.taskComplete = CoreClrFuncInvokeContext::TaskComplete;
+	context.releaseV8Function = CoreClrNodejsFunc::QueueRelease;
+	context.minExternalStringLength = minExternalStringLength;
+	context.pinByteArrays = enablePinnedByteArrays;
 
 	if (!context.applicationDirectory)
 	{
@@ -635,7 +640,7 @@ HRESULT CoreClrEmbedding::Initialize(BOOL debugMode)
 	if (exception)
 	{
 		v8::Local<v8::Value> v8Exception = CoreClrFunc::MarshalCLRToV8(exception, V8TypeException);
-		FreeMarshalData(exception, V8TypeException);
+		CoreClrFunc::FreeMarshalData(exception, V8TypeException);
 
 		throwV8Exception(v8Exception);
 		return E_FAIL;
@@ -652,7 +657,7 @@ HRESULT CoreClrEmbedding::Initialize(BOOL debugMode)
 	if (exception)
 	{
 		v8::Local<v8::Value> v8Exception = CoreClrFunc::MarshalCLRToV8(exception, V8TypeException);
-		FreeMarshalData(exception, V8TypeException);
+		CoreClrFunc::FreeMarshalData(exception, V8TypeException);
 
 		throwV8Exception(v8Exception);
 		return E_FAIL;
@@ -678,7 +683,7 @@ CoreClrGcHandle CoreClrEmbedding::GetClrFuncReflectionWrapFunc(const char* assem
 	if (exception)
 	{
 		*v8Exception = CoreClrFunc::MarshalCLRToV8(exception, V8TypeException);
-		FreeMarshalData(exception, V8TypeException);
+		CoreClrFunc::FreeMarshalData(exception, V8TypeException);
 
 		return NULL;
 	}
@@ -690,16 +695,16 @@ CoreClrGcHandle CoreClrEmbedding::GetClrFuncReflectionWrapFunc(const char* assem
 	}
 }
 
-void CoreClrEmbedding::CallClrFunc(CoreClrGcHandle functionHandle, void* payload, int payloadType, int* taskState, void** result, int* resultType)
+void CoreClrEmbedding::CallClrFunc(CoreClrGcHandle functionHandle, void* payload, int payloadType, int64_t scalarPayload, int* taskState, void** result, int* resultType, int64_t* scalarResult)
 {
 	trace::info(_X("CoreClrEmbedding::CallClrFunc"));
-	callFunc(functionHandle, payload, payloadType, taskState, result, resultType);
+	callFunc(functionHandle, payload, payloadType, scalarPayload, taskState, result, resultType, scalarResult);
 }
 
-void CoreClrEmbedding::ContinueTask(CoreClrGcHandle taskHandle, void* context, TaskCompleteFunction callback, void** exception)
+void CoreClrEmbedding::ContinueTask(CoreClrGcHandle taskHandle, void* context, void** exception)
 {
 	trace::info(_X("CoreClrEmbedding::ContinueTask"));
-	continueTask(taskHandle, context, callback, exception);
+	continueTask(taskHandle, context, exception);
 }
 
 void CoreClrEmbedding::FreeHandle(CoreClrGcHandle handle)
@@ -708,12 +713,6 @@ void CoreClrEmbedding::FreeHandle(CoreClrGcHandle handle)
 	freeHandle(handle);
 }
 
-void CoreClrEmbedding::FreeMarshalData(void* marshalData, int marshalDataType)
-{
-	trace::info(_X("CoreClrEmbedding::FreeMarshalData"));
-	freeMarshalData(marshalData, marshalDataType);
-}
-
 CoreClrGcHandle CoreClrEmbedding::CompileFunc(const void* options, const int payloadType, v8::Local<v8::Value>* v8Exception)
 {
     trace::info(_X("CoreClrEmbedding::CompileFunc - Starting"));
@@ -724,7 +723,7 @@ CoreClrGcHandle CoreClrEmbedding::CompileFunc(const void* options, const int pay
     if (exception)
     {
         *v8Exception = CoreClrFunc::MarshalCLRToV8(exception, V8TypeException);
-        FreeMarshalData(exception, V8TypeException);
+        CoreClrFunc::FreeMarshalData(exception, V8TypeException);
 
         return NULL;
     }
@@ -1,18 +1,82 @@
 #include "edge.h"
 
+int CoreClrFunc::liveCount = 0;
+
 CoreClrFunc::CoreClrFunc()
 {
 	functionHandle = NULL;
+	offload = false;
+	promise = false;
+	bufferMode = BufferMarshalModeCopy;
+	references = 1;
+	liveCount++;
+}
+
+CoreClrFunc::~CoreClrFunc()
+{
+	DBG("CoreClrFunc::~CoreClrFunc");
+
+	if (functionHandle)
+	{
+		CoreClrEmbedding::FreeHandle(functionHandle);
+		functionHandle = NULL;
+	}
+
+	liveCount--;
+}
+
+void CoreClrFunc::AddRef()
+{
+	references++;
+}
+
+void CoreClrFunc::Release(CoreClrFunc* function)
+{
+	if (function && --function->references == 0)
+	{
+		delete function;
+	}
+}
+
+int CoreClrFunc::GetLiveCount()
+{
+	return liveCount;
 }
 
 NAN_METHOD(coreClrFuncProxy)
 {
     DBG("coreClrFuncProxy");
     Nan::EscapableHandleScope scope;
-    v8::Local<v8::External> correlator = v8::Local<v8::External>::Cast(info[2]);
-    CoreClrFuncWrap* wrap = (CoreClrFuncWrap*)(correlator->Value());
+    CoreClrFuncWrap* wrap = (CoreClrFuncWrap*)(info.Data().As<v8::External>()->Value());
     CoreClrFunc* clrFunc = wrap->clrFunc;
+
+    if (!clrFunc)
+    {
+        return Nan::ThrowError("The CLR function has been disposed.");
+    }
+
+    // JavaScript called back synchronously by the CLR may dispose the proxy while the call is in progress
+    clrFunc->AddRef();
     info.GetReturnValue().Set(clrFunc->Call(info[0], info[1]));
+    CoreClrFunc::Release(clrFunc);
+}
+
+NAN_METHOD(coreClrFuncProxyDispose)
+{
+    DBG("coreClrFuncProxyDispose");
+    v8::Local<v8::Value> correlator = Nan::GetPrivate(info.This(), Nan::New<v8::String>("edge::clrFunc").ToLocalChecked()).ToLocalChecked();
+
+    if (!correlator->IsExternal())
+    {
+        // dispose was called on something else than a proxy
+        return;
+    }
+
+    CoreClrFuncWrap* wrap = (CoreClrFuncWrap*)(correlator.As<v8::External>()->Value());
+
+    // The wrap itself lives until the proxy is collected, calls made after disposal throw
+    CoreClrFunc::Release(wrap->clrFunc);
+    wrap->clrFunc = NULL;
 }
 
 template<typename T>
@@ -20,42 +84,38 @@ void coreClrFuncProxyNearDeath(const Nan::WeakCallbackInfo<T> &data)
 {
     DBG("coreClrFuncProxyNearDeath");
     CoreClrFuncWrap* wrap = (CoreClrFuncWrap*)(data.GetParameter());
-	delete wrap->clrFunc;
+	CoreClrFunc::Release(wrap->clrFunc);
     wrap->clrFunc = NULL;
     delete wrap;
 }
 
-v8::Local<v8::Function> CoreClrFunc::InitializeInstance(CoreClrGcHandle functionHandle)
+v8::Local<v8::Function> CoreClrFunc::InitializeInstance(CoreClrGcHandle functionHandle, bool offload, bool promise, BufferMarshalMode bufferMode)
 {
     DBG("CoreClrFunc::InitializeInstance - Started");
 
-    static Nan::Persistent<v8::Function> proxyFactory;
-    static Nan::Persistent<v8::Function> proxyFunction;
+    static Nan::Persistent<v8::Function> proxyDisposeFunction;
 
     Nan::EscapableHandleScope scope;
 
     CoreClrFunc* app = new CoreClrFunc();
     app->functionHandle = functionHandle;
+    app->offload = offload;
+    app->promise = promise;
+    app->bufferMode = bufferMode;
     CoreClrFuncWrap* wrap = new CoreClrFuncWrap();
     wrap->clrFunc = app;
 
-    // See https://github.com/tjanczuk/edge/issues/128 for context
-
-    if (proxyFactory.IsEmpty())
+    if (proxyDisposeFunction.IsEmpty())
     {
-    	DBG("CoreClrFunc::InitializeInstance - Creating proxy factory");
-
-		v8::Local<v8::Function> clrFuncProxyFunction = Nan::New<v8::FunctionTemplate>(coreClrFuncProxy)->GetFunction();
-		proxyFunction.Reset(clrFuncProxyFunction);
-		v8::Local<v8::String> code = Nan::New<v8::String>(
-			"(function (f, ctx) { return function (d, cb) { return f(d, cb, ctx); }; })").ToLocalChecked();
-		v8::Local<v8::Function> codeFunction = v8::Local<v8::Function>::Cast(v8::Script::Compile(code)->Run());
-		proxyFactory.Reset(codeFunction);
+		proxyDisposeFunction.Reset(Nan::New<v8::FunctionTemplate>(coreClrFuncProxyDispose)->GetFunction());
     }
 
-	v8::Local<v8::Value> factoryArgv[] = { Nan::New(proxyFunction), Nan::New<v8::External>((void*)wrap) };
-	v8::Local<v8::Function> funcProxy =
-        (Nan::Call(Nan::New(proxyFactory), Nan::GetCurrentContext()->Global(), 2, factoryArgv)).ToLocalChecked().As<v8::Function>();
+	// Every proxy is a native function of its own that carries the wrap in its data, so calls go straight to
+	// coreClrFuncProxy. The dispose function is shared and finds the wrap of the proxy through a private property.
+	v8::Local<v8::External> correlator = Nan::New<v8::External>((void*)wrap);
+	v8::Local<v8::Function> funcProxy = Nan::New<v8::Function>(coreClrFuncProxy, correlator);
+	Nan::SetPrivate(funcProxy, Nan::New<v8::String>("edge::clrFunc").ToLocalChecked(), correlator);
+	Nan::Set(funcProxy, Nan::New<v8::String>("dispose").ToLocalChecked(), Nan::New(proxyDisposeFunction));
 	Nan::Persistent<v8::Function> funcProxyPersistent(funcProxy);
 	funcProxyPersistent.SetWeak((void*)wrap, &coreClrFuncProxyNearDeath, Nan::WeakCallbackType::kParameter);
 
@@ -69,19 +129,55 @@ v8::Local<v8::Value> CoreClrFunc::Call(v8::Local<v8::Value> payload, v8::Local<v
 	DBG("CoreClrFunc::Call - Started");
 	Nan::EscapableHandleScope scope;
 
-	void* marshalData;
+	void* marshalData = NULL;
 	int payloadType;
+	int64_t scalarPayload = 0;
 	int taskState;
 	void* result;
 	int resultType;
+	int64_t scalarResult = 0;
+	v8::Local<v8::Promise::Resolver> resolver;
+
+	if (promise && callbackOrSync->IsUndefined())
+	{
+		// Calls without a callback complete a promise created for them, it is returned once the call is started
+		resolver = v8::Promise::Resolver::New(Nan::GetCurrentContext()).ToLocalChecked();
+	}
 
 	DBG("CoreClrFunc::Call - Marshalling data in preparation for calling the CLR");
 
-	MarshalV8ToCLR(payload, &marshalData, &payloadType);
+	if (!MarshalV8ToCLRScalar(payload, &scalarPayload, &payloadType))
+	{
+		MarshalV8ToCLR(payload, &marshalData, &payloadType, bufferMode);
+	}
+
 	DBG("CoreClrFunc::Call - Object type of %d is being marshalled", payloadType);
 
+	if (offload && !callbackOrSync->IsBoolean())
+	{
+		DBG("CoreClrFunc::Call - Offloading the call to the thread pool");
+
+		// The marshalled payload is owned by the offloaded call from this point on
+		CoreClrFuncInvokeContext* invokeContext = CoreClrFuncInvokeContext::Acquire(callbackOrSync, resolver);
+		invokeContext->InitializeAsyncOperation();
+
+		if (bufferMode == BufferMarshalModeView)
+		{
+			invokeContext->KeepAlive(payload);
+		}
+
+		invokeContext->Offload(this, functionHandle, marshalData, payloadType, scalarPayload);
+
+		if (!resolver.IsEmpty())
+		{
+			return scope.Escape(resolver->GetPromise());
+		}
+
+		return scope.Escape(Nan::Undefined());
+	}
+
 	DBG("CoreClrFunc::Call - Calling CoreClrEmbedding::CallClrFunc()");
-	CoreClrEmbedding::CallClrFunc(functionHandle, marshalData, payloadType, &taskState, &result, &resultType);
+	CoreClrEmbedding::CallClrFunc(functionHandle, marshalData, payloadType, scalarPayload, &taskState, &result, &resultType, &scalarResult);
 	DBG("CoreClrFunc::Call - CoreClrEmbedding::CallClrFunc() returned a task state of %d", taskState);
 
 	DBG("CoreClrFunc::Call - Freeing the data marshalled to the CLR");
@@ -99,22 +195,41 @@ v8::Local<v8::Value> CoreClrFunc::Call(v8::Local<v8::Value> payload, v8::Local<v
 			DBG("CoreClrFunc::Call - Task threw an exception, marshalling CLR exception data to V8");
 		}
 
-		if (callbackOrSync->IsBoolean() || taskState == TaskStatusFaulted)
+		if (!resolver.IsEmpty())
+		{
+			v8::Local<v8::Value> v8Result = CoreClrFunc::MarshalCLRToV8(result, resultType, scalarResult);
+			FreeMarshalData(result, resultType);
+
+			if (taskState == TaskStatusRanToCompletion)
+			{
+				resolver->Resolve(Nan::GetCurrentContext(), v8Result).FromJust();
+			}
+
+			else
+			{
+				resolver->Reject(Nan::GetCurrentContext(), v8Result).FromJust();
+			}
+		}
+
+		else if (callbackOrSync->IsBoolean() || taskState == TaskStatusFaulted)
 		{
+			v8::Local<v8::Value> v8Result = CoreClrFunc::MarshalCLRToV8(result, resultType, scalarResult);
+			FreeMarshalData(result, resultType);
+
 			if (taskState == TaskStatusRanToCompletion)
 			{
-				return scope.Escape(CoreClrFunc::MarshalCLRToV8(result, resultType));
+				return scope.Escape(v8Result);
 			}
 
 			else
 			{
-				Nan::ThrowError(CoreClrFunc::MarshalCLRToV8(result, resultType));
+				Nan::ThrowError(v8Result);
 			}
 		}
 
 		else
 		{
-			CoreClrFuncInvokeContext::TaskCompleteSynchronous(result, resultType, taskState, callbackOrSync);
+			CoreClrFuncInvokeContext::TaskCompleteSynchronous(result, resultType, scalarResult, taskState, callbackOrSync);
 		}
 	}
 
@@ -131,12 +246,18 @@ v8::Local<v8::Value> CoreClrFunc::Call(v8::Local<v8::Value> payload, v8::Local<v
 		DBG("CoreClrFunc::Call - Task running asynchronously, registering callback");
 
 		CoreClrGcHandle taskHandle = result;
-		CoreClrFuncInvokeContext* invokeContext = new CoreClrFuncInvokeContext(callbackOrSync, taskHandle);
+		CoreClrFuncInvokeContext* invokeContext = CoreClrFuncInvokeContext::Acquire(callbackOrSync, resolver);
 
 		invokeContext->InitializeAsyncOperation();
 
+		if (bufferMode == BufferMarshalModeView)
+		{
+			invokeContext->KeepAlive(payload);
+		}
+
 		void* exception;
-		CoreClrEmbedding::ContinueTask(taskHandle, invokeContext, CoreClrFuncInvokeContext::TaskComplete, &exception);
+		// The CLR releases the task handle once it has registered the continuation
+		CoreClrEmbedding::ContinueTask(taskHandle, invokeContext, &exception);
 
 		if (exception)
 		{
@@ -146,6 +267,11 @@ v8::Local<v8::Value> CoreClrFunc::Call(v8::Local<v8::Value> payload, v8::Local<v
 
 	DBG("CoreClrFunc::Call - Finished");
 
+	if (!resolver.IsEmpty())
+	{
+		return scope.Escape(resolver->GetPromise());
+	}
+
 	return scope.Escape(Nan::Undefined());
 }
 
@@ -156,6 +282,9 @@ NAN_METHOD(CoreClrFunc::Initialize)
 	Nan::EscapableHandleScope scope;
 	v8::Local<v8::Object> options = info[0]->ToObject();
 	v8::Local<v8::Function> result;
+	bool offload = options->Get(Nan::New<v8::String>("offload").ToLocalChecked())->IsTrue();
+	bool promise = options->Get(Nan::New<v8::String>("promise").ToLocalChecked())->IsTrue();
+	BufferMarshalMode bufferMode = GetBufferMarshalMode(options);
 
 	v8::Local<v8::Value> assemblyFileArgument = options->Get(Nan::New<v8::String>("assemblyFile").ToLocalChecked());
 
@@ -173,7 +302,7 @@ NAN_METHOD(CoreClrFunc::Initialize)
 		{
 			DBG("CoreClrFunc::Initialize - Function loaded successfully");
 
-			result = CoreClrFunc::InitializeInstance(functionHandle);
+			result = CoreClrFunc::InitializeInstance(functionHandle, offload, promise, bufferMode);
 			DBG("CoreClrFunc::Initialize - Callback initialized successfully");
 		}
 
@@ -194,12 +323,13 @@ NAN_METHOD(CoreClrFunc::Initialize)
 
 		DBG("CoreClrFunc::Initialize - Compiling dynamic .NET function");
 		CoreClrGcHandle functionHandle = CoreClrEmbedding::CompileFunc(marshalledOptionsData, payloadType, &exception);
+		FreeMarshalData(marshalledOptionsData, payloadType);
 
 		if (functionHandle)
 		{
 			DBG("CoreClrFunc::Initialize - Function compiled successfully");
 
-			result = CoreClrFunc::InitializeInstance(functionHandle);
+			result = CoreClrFunc::InitializeInstance(functionHandle, offload, promise, bufferMode);
 			DBG("CoreClrFunc::Initialize - Callback initialized successfully");
 		}
 
@@ -217,68 +347,180 @@ NAN_METHOD(CoreClrFunc::Initialize)
 
 void CoreClrFunc::FreeMarshalData(void* marshalData, int payloadType)
 {
+	// Marshalled data is a single block regardless of its type and which side wrote it
+	FreeMarshalBlock(marshalData);
+}
+
+void CoreClrFunc::FreeUnreadMarshalData(void* marshalData, int payloadType)
+{
+	if (marshalData)
+	{
+		MarshalReader reader(marshalData);
+		ReleaseUnreadMarshalData(&reader, payloadType);
+	}
+
+	FreeMarshalBlock(marshalData);
+}
+
+void CoreClrFunc::ReleaseUnreadMarshalData(MarshalReader* reader, int payloadType)
+{
+	// Walks a block written by the CLR and releases the pinned memory and function handles its reader would have owned
+
 	switch (payloadType)
 	{
 		case V8TypeString:
-			delete ((char*)marshalData);
-			break;
-
-		case V8TypeObject:
-			delete ((V8ObjectData*)marshalData);
+		{
+			int32_t header = reader->ReadInt32();
+			reader->ReadBytes((header & 1) ? (header >> 1) : (header >> 1) * sizeof(uint16_t));
 			break;
+		}
 
+		case V8TypeInt32:
+		case V8TypeUInt32:
 		case V8TypeBoolean:
-			delete ((bool*)marshalData);
+			reader->ReadInt32();
 			break;
 
 		case V8TypeNumber:
 		case V8TypeDate:
-			delete ((double*)marshalData);
+			reader->ReadDouble();
 			break;
 
-		case V8TypeInt32:
-			delete ((int32_t*)marshalData);
+		case V8TypeBuffer:
+			reader->ReadBytes(reader->ReadInt32());
 			break;
 
-		case V8TypeUInt32:
-			delete ((uint32_t*)marshalData);
+		case V8TypeBufferView:
+		case V8TypeExternalString:
+		{
+			reader->ReadInt32();
+			reader->ReadPointer();
+			ReleaseBufferFunction release = (ReleaseBufferFunction)reader->ReadPointer();
+			void* releaseContext = reader->ReadPointer();
+
+			if (release)
+			{
+				release(releaseContext);
+			}
+
 			break;
+		}
+
+		case V8TypeTypedArray:
+		{
+			TypedArrayType arrayType = (TypedArrayType)reader->ReadInt32();
+			reader->ReadBytes(reader->ReadInt32() * GetTypedArrayElementSize(arrayType));
+			break;
+		}
 
-		case V8TypeNull:
+		case V8TypeFunction:
+			CoreClrEmbedding::FreeHandle(reader->ReadPointer());
 			break;
 
 		case V8TypeArray:
-			delete ((V8ArrayData*)marshalData);
+		{
+			int arrayLength = reader->ReadInt32();
+
+			for (int i = 0; i < arrayLength; i++)
+			{
+				ReleaseUnreadMarshalData(reader, reader->ReadInt32());
+			}
+
+			break;
+		}
+
+		case V8TypePackedArray:
+		{
+			int itemType = reader->ReadInt32();
+			int arrayLength = reader->ReadInt32();
+
+			for (int i = 0; i < arrayLength; i++)
+			{
+				ReleaseUnreadMarshalData(reader, itemType);
+			}
+
 			break;
+		}
+
+		case V8TypeShapedObject:
+		{
+			MarshalReader descriptorReader(reader->ReadPointer());
+			int propertyCount = descriptorReader.ReadInt32();
 
-        case V8TypeBuffer:
-            delete ((V8BufferData*)marshalData);
-            break;
+			for (int i = 0; i < propertyCount; i++)
+			{
+				ReleaseUnreadMarshalData(reader, reader->ReadInt32());
+			}
+
+			break;
+		}
+
+		case V8TypeObject:
+		case V8TypeException:
+		{
+			int propertiesCount = reader->ReadInt32();
+
+			for (int i = 0; i < propertiesCount; i++)
+			{
+				ReleaseUnreadMarshalData(reader, V8TypeString);
+				ReleaseUnreadMarshalData(reader, reader->ReadInt32());
+			}
+
+			break;
+		}
+
+		default:
+			// Null carries no data
+			break;
 	}
 }
 
-char* CoreClrFunc::CopyV8StringBytes(v8::Local<v8::String> v8String)
+bool CoreClrFunc::MarshalV8ToCLRScalar(v8::Local<v8::Value> jsdata, int64_t* scalar, int* payloadType)
 {
-	String::Utf8Value utf8String(v8String);
-	char* sourceBytes = *utf8String;
-#ifdef EDGE_PLATFORM_WINDOWS
-	size_t sourceLength = strlen(sourceBytes);
-#else
-	int sourceLength = strlen(sourceBytes);
-#endif
-	char* destinationBytes = new char[sourceLength + 1];
+	if (jsdata->IsBoolean())
+	{
+		*scalar = jsdata->BooleanValue() ? 1 : 0;
+		*payloadType = V8TypeBoolean;
+	}
 
-	strncpy(destinationBytes, sourceBytes, sourceLength);
-	destinationBytes[sourceLength] = '\0';
+	else if (jsdata->IsInt32())
+	{
+		*scalar = jsdata->Int32Value();
+		*payloadType = V8TypeInt32;
+	}
+
+	else if (jsdata->IsUint32())
+	{
+		*scalar = jsdata->Uint32Value();
+		*payloadType = V8TypeUInt32;
+	}
 
-	return destinationBytes;
+	else if (jsdata->IsNumber())
+	{
+		double value = jsdata->NumberValue();
+
+		memcpy(scalar, &value, sizeof(double));
+		*payloadType = V8TypeNumber;
+	}
+
+	else if (jsdata->IsUndefined() || jsdata->IsNull())
+	{
+		*scalar = 0;
+		*payloadType = V8TypeNull;
+	}
+
+	else
+	{
+		return false;
+	}
+
+	return true;
 }
 
 void CoreClrFunc::MarshalV8ExceptionToCLR(v8::Local<v8::Value> exception, void** marshalData)
 {
 	Nan::HandleScope scope;
-
-    int payloadType;
+	MarshalWriter writer;
 
     if (exception->IsObject())
     {
@@ -286,174 +528,459 @@ void CoreClrFunc::MarshalV8ExceptionToCLR(v8::Local<v8::Value> exception, void**
 
         if (stack->IsString())
         {
-        	MarshalV8ToCLR(stack, marshalData, &payloadType);
+        	writer.WriteString(v8::Local<v8::String>::Cast(stack));
+        	*marshalData = writer.Detach();
         	return;
         }
     }
 
-    *marshalData = CopyV8StringBytes(v8::Local<v8::String>::Cast(exception));
+    writer.WriteString(Nan::To<v8::String>(exception).ToLocalChecked());
+    *marshalData = writer.Detach();
+}
+
+void CoreClrFunc::MarshalV8ToCLR(v8::Local<v8::Value> jsdata, void** marshalData, int* payloadType, BufferMarshalMode bufferMode)
+{
+	MarshalWriter writer;
+
+	*payloadType = MarshalV8ToCLR(&writer, jsdata, bufferMode);
+	*marshalData = writer.Detach();
+}
+
+static std::unordered_map<const void*, CoreClrObjectShape*> objectShapes;
+
+CoreClrObjectShape* CoreClrFunc::GetObjectShape(const void* shapeDescriptor)
+{
+	std::unordered_map<const void*, CoreClrObjectShape*>::iterator cachedShape = objectShapes.find(shapeDescriptor);
+
+	if (cachedShape != objectShapes.end())
+	{
+		return cachedShape->second;
+	}
+
+	Nan::HandleScope scope;
+	MarshalReader reader(shapeDescriptor);
+	CoreClrObjectShape* shape = new CoreClrObjectShape();
+	v8::Local<v8::ObjectTemplate> objectTemplate = Nan::New<v8::ObjectTemplate>();
+
+	shape->propertyCount = reader.ReadInt32();
+	shape->propertyNames = new Nan::Persistent<v8::String>[shape->propertyCount];
+
+	DBG("CoreClrFunc::GetObjectShape - Caching shape with %d properties", shape->propertyCount);
+
+	for (int i = 0; i < shape->propertyCount; i++)
+	{
+		v8::Local<v8::String> name = reader.ReadString(v8::NewStringType::kInternalized);
+
+		shape->propertyNames[i].Reset(name);
+		objectTemplate->Set(name, Nan::Undefined());
+	}
+
+	shape->objectTemplate.Reset(objectTemplate);
+	objectShapes[shapeDescriptor] = shape;
+
+	return shape;
 }
 
-void CoreClrFunc::MarshalV8ToCLR(v8::Local<v8::Value> jsdata, void** marshalData, int* payloadType)
+// Property names seen repeatedly in JavaScript objects, bucketed by their hash. The CLR keeps one string
+// for each name record, so names of repeated payload shapes are neither encoded nor allocated again.
+typedef std::unordered_multimap<int, CoreClrPropertyName*> CoreClrPropertyNameMap;
+static CoreClrPropertyNameMap propertyNames;
+
+void CoreClrFunc::WritePropertyName(MarshalWriter* writer, v8::Local<v8::String> name)
+{
+	int hash = name->GetIdentityHash();
+	std::pair<CoreClrPropertyNameMap::iterator, CoreClrPropertyNameMap::iterator> bucket = propertyNames.equal_range(hash);
+	CoreClrPropertyName* propertyName = NULL;
+
+	for (CoreClrPropertyNameMap::iterator cachedName = bucket.first; cachedName != bucket.second; cachedName++)
+	{
+		if (Nan::New(cachedName->second->name)->StrictEquals(name))
+		{
+			propertyName = cachedName->second;
+			break;
+		}
+	}
+
+	if (!propertyName && propertyNames.size() < EDGE_MAX_CACHED_PROPERTY_NAMES && IsRepeatedPropertyName(hash))
+	{
+		MarshalWriter recordWriter;
+
+		recordWriter.WritePointer(NULL);
+		recordWriter.WriteString(name);
+
+		propertyName = new CoreClrPropertyName();
+		propertyName->name.Reset(name);
+		propertyName->record = recordWriter.Detach();
+		propertyNames.insert(std::make_pair(hash, propertyName));
+	}
+
+	// Names seen for the first time or that do not fit in the cache are written in full
+	if (propertyName)
+	{
+		writer->WriteInt32(-1);
+		writer->WritePointer(propertyName->record);
+		return;
+	}
+
+	writer->WriteString(name);
+}
+
+int CoreClrFunc::GetPackedArrayType(v8::Local<v8::Array> jsarray, unsigned int arrayLength)
+{
+	int packedArrayType = 0;
+
+	// Arrays whose items are all int32, numbers, booleans or strings are sent without per item tags
+	// and arrive in the CLR as int[], double[], bool[] or string[]
+	for (unsigned int i = 0; i < arrayLength; i++)
+	{
+		v8::Local<v8::Value> item = jsarray->Get(i);
+		int itemType;
+
+		if (item->IsInt32())
+		{
+			itemType = V8TypeInt32;
+		}
+		else if (item->IsNumber())
+		{
+			itemType = V8TypeNumber;
+		}
+		else if (item->IsBoolean())
+		{
+			itemType = V8TypeBoolean;
+		}
+		else if (item->IsString())
+		{
+			itemType = V8TypeString;
+		}
+		else
+		{
+			return 0;
+		}
+
+		// A mix of int32 and other numbers is sent as doubles
+		if ((packedArrayType == V8TypeInt32 || packedArrayType == V8TypeNumber)
+			&& (itemType == V8TypeInt32 || itemType == V8TypeNumber))
+		{
+			if (itemType == V8TypeNumber)
+			{
+				packedArrayType = V8TypeNumber;
+			}
+		}
+		else if (packedArrayType && packedArrayType != itemType)
+		{
+			return 0;
+		}
+		else
+		{
+			packedArrayType = itemType;
+		}
+	}
+
+	return packedArrayType;
+}
+
+int CoreClrFunc::MarshalV8ToCLR(MarshalWriter* writer, v8::Local<v8::Value> jsdata, BufferMarshalMode bufferMode)
 {
 	if (jsdata->IsString())
 	{
-		*marshalData = CopyV8StringBytes(v8::Local<v8::String>::Cast(jsdata));
-		*payloadType = V8TypeString;
+		writer->WriteString(v8::Local<v8::String>::Cast(jsdata));
+		return V8TypeString;
 	}
 
 	else if (jsdata->IsFunction())
 	{
-		*marshalData = new CoreClrNodejsFunc(v8::Local<v8::Function>::Cast(jsdata));
-		*payloadType = V8TypeFunction;
+		writer->WritePointer(new CoreClrNodejsFunc(v8::Local<v8::Function>::Cast(jsdata)));
+		return V8TypeFunction;
+	}
+
+	// Every ArrayBufferView passes node::Buffer::HasInstance, so typed arrays are picked out first.
+	// Uint8Arrays, Buffers among them, keep marshaling as byte[] or Stream according to the buffer mode.
+	else if (GetTypedArrayType(jsdata) != TypedArrayTypeNone && !jsdata->IsUint8Array())
+	{
+		v8::Local<v8::TypedArray> typedArray = v8::Local<v8::TypedArray>::Cast(jsdata);
+		size_t byteLength = typedArray->ByteLength();
+
+		writer->WriteInt32(GetTypedArrayType(jsdata));
+		writer->WriteInt32((int32_t)typedArray->Length());
+		typedArray->CopyContents(writer->Reserve(byteLength), byteLength);
+		return V8TypeTypedArray;
 	}
 
 	else if (node::Buffer::HasInstance(jsdata))
 	{
 		v8::Local<v8::Object> jsBuffer = jsdata->ToObject();
-		V8BufferData* bufferData = new V8BufferData();
+		int bufferLength = (int)node::Buffer::Length(jsBuffer);
+
+		writer->WriteInt32(bufferLength);
+
+		if (bufferMode == BufferMarshalModeView)
+		{
+			writer->WritePointer(node::Buffer::Data(jsBuffer));
+			writer->WritePointer(NULL);
+			writer->WritePointer(NULL);
+			return V8TypeBufferView;
+		}
 
-		bufferData->bufferLength = (int)node::Buffer::Length(jsBuffer);
-		bufferData->buffer = new char[bufferData->bufferLength];
+		else if (bufferMode == BufferMarshalModeTransfer)
+		{
+			void* releaseContext;
+			char* buffer = DetachBufferData(jsBuffer, &releaseContext);
 
-		memcpy(bufferData->buffer, node::Buffer::Data(jsBuffer), bufferData->bufferLength);
+			writer->WritePointer(buffer);
+			writer->WritePointer((void*)FreeDetachedBufferData);
+			writer->WritePointer(releaseContext);
+			return V8TypeBufferView;
+		}
 
-		*marshalData = bufferData;
-		*payloadType = V8TypeBuffer;
+		memcpy(writer->Reserve(bufferLength), node::Buffer::Data(jsBuffer), bufferLength);
+		return V8TypeBuffer;
 	}
 
 	else if (jsdata->IsArray())
 	{
 		v8::Local<v8::Array> jsarray = v8::Local<v8::Array>::Cast(jsdata);
-		V8ArrayData* arrayData = new V8ArrayData();
+		unsigned int arrayLength = jsarray->Length();
+		int packedArrayType = enableMarshalPackedArrays ? GetPackedArrayType(jsarray, arrayLength) : 0;
+
+		if (packedArrayType)
+		{
+			writer->WriteInt32(packedArrayType);
+			writer->WriteInt32((int32_t)arrayLength);
+
+			for (unsigned int i = 0; i < arrayLength; i++)
+			{
+				v8::Local<v8::Value> item = jsarray->Get(i);
+
+				switch (packedArrayType)
+				{
+					case V8TypeInt32:
+						writer->WriteInt32(item->Int32Value());
+						break;
+					case V8TypeNumber:
+						writer->WriteDouble(item->NumberValue());
+						break;
+					case V8TypeBoolean:
+						writer->WriteInt32(item->BooleanValue() ? 1 : 0);
+						break;
+					default:
+						writer->WriteString(v8::Local<v8::String>::Cast(item));
+						break;
+				}
+			}
+
+			return V8TypePackedArray;
+		}
 
-		arrayData->arrayLength = jsarray->Length();
-		arrayData->itemTypes = new int[arrayData->arrayLength];
-		arrayData->itemValues = new void*[arrayData->arrayLength];
+		writer->WriteInt32((int32_t)arrayLength);
 
-		for (int i = 0; i < arrayData->arrayLength; i++)
+		for (unsigned int i = 0; i < arrayLength; i++)
 		{
-			MarshalV8ToCLR(jsarray->Get(i), &arrayData->itemValues[i], &arrayData->itemTypes[i]);
+			size_t itemTypeOffset = writer->ReserveInt32();
+			writer->WriteInt32At(itemTypeOffset, MarshalV8ToCLR(writer, jsarray->Get(i), bufferMode));
 		}
 
-		*marshalData = arrayData;
-		*payloadType = V8TypeArray;
+		return V8TypeArray;
 	}
 
 	else if (jsdata->IsDate())
 	{
 		v8::Local<v8::Date> jsdate = v8::Local<v8::Date>::Cast(jsdata);
-		double* ticks = new double();
 
-		*ticks = jsdate->NumberValue();
-		*marshalData = ticks;
-		*payloadType = V8TypeDate;
+		writer->WriteDouble(jsdate->NumberValue());
+		return V8TypeDate;
 	}
 
 	else if (jsdata->IsBoolean())
 	{
-		bool* value = new bool();
-		*value = jsdata->BooleanValue();
-
-		*marshalData = value;
-		*payloadType = V8TypeBoolean;
+		writer->WriteInt32(jsdata->BooleanValue() ? 1 : 0);
+		return V8TypeBoolean;
 	}
 
 	else if (jsdata->IsInt32())
 	{
-		int32_t* value = new int32_t();
-		*value = jsdata->Int32Value();
-
-		*marshalData = value;
-		*payloadType = V8TypeInt32;
+		writer->WriteInt32(jsdata->Int32Value());
+		return V8TypeInt32;
 	}
 
 	else if (jsdata->IsUint32())
 	{
-		uint32_t* value = new uint32_t();
-		*value = jsdata->Uint32Value();
-
-		*marshalData = value;
-		*payloadType = V8TypeUInt32;
+		writer->WriteInt32((int32_t)jsdata->Uint32Value());
+		return V8TypeUInt32;
 	}
 
 	else if (jsdata->IsNumber())
 	{
-		double* value = new double();
-		*value = jsdata->NumberValue();
-
-		*marshalData = value;
-		*payloadType = V8TypeNumber;
+		writer->WriteDouble(jsdata->NumberValue());
+		return V8TypeNumber;
 	}
 
 	else if (jsdata->IsUndefined() || jsdata->IsNull())
 	{
-		*payloadType = V8TypeNull;
+		return V8TypeNull;
 	}
 
 	else if (jsdata->IsObject())
 	{
-		V8ObjectData* objectData = new V8ObjectData();
-
 		v8::Local<v8::Object> jsobject = v8::Local<v8::Object>::Cast(jsdata);
-		v8::Local<v8::Array> propertyNames = jsobject->GetPropertyNames();
+		v8::Local<v8::Array> propertyNames = Nan::GetOwnPropertyNames(jsobject).ToLocalChecked();
+		unsigned int propertiesCount = propertyNames->Length();
 
-		objectData->propertiesCount = propertyNames->Length();
-		objectData->propertyData = new void*[objectData->propertiesCount];
-		objectData->propertyNames = new char*[objectData->propertiesCount];
-		objectData->propertyTypes = new int[objectData->propertiesCount];
+		writer->WriteInt32((int32_t)propertiesCount);
 
-		for (unsigned int i = 0; i < propertyNames->Length(); i++)
+		for (unsigned int i = 0; i < propertiesCount; i++)
 		{
-			v8::Local<v8::String> name = v8::Local<v8::String>::Cast(propertyNames->Get(i));
+			v8::Local<v8::String> name = Nan::To<v8::String>(propertyNames->Get(i)).ToLocalChecked();
 
-			objectData->propertyNames[i] = CopyV8StringBytes(name);
-			MarshalV8ToCLR(jsobject->Get(name), &objectData->propertyData[i], &objectData->propertyTypes[i]);
+			WritePropertyName(writer, name);
+
+			size_t propertyTypeOffset = writer->ReserveInt32();
+			writer->WriteInt32At(propertyTypeOffset, MarshalV8ToCLR(writer, jsobject->Get(name), bufferMode));
 		}
 
-		*marshalData = objectData;
-		*payloadType = V8TypeObject;
+		return V8TypeObject;
 	}
+
+	return V8TypeNull;
 }
 
 v8::Local<v8::Value> CoreClrFunc::MarshalCLRToV8(void* marshalData, int payloadType)
+{
+	MarshalReader reader(marshalData);
+	return MarshalCLRToV8(&reader, payloadType);
+}
+
+v8::Local<v8::Value> CoreClrFunc::MarshalCLRToV8(void* marshalData, int payloadType, int64_t scalar)
+{
+	Nan::EscapableHandleScope scope;
+
+	// Scalar results are passed by value, see CallFuncFunction
+	if (!marshalData)
+	{
+		if (payloadType == V8TypeBoolean)
+		{
+			return scope.Escape(Nan::New<v8::Boolean>(scalar != 0));
+		}
+
+		else if (payloadType == V8TypeInt32)
+		{
+			return scope.Escape(Nan::New<v8::Integer>((int32_t)scalar));
+		}
+
+		else if (payloadType == V8TypeNumber)
+		{
+			double value;
+
+			memcpy(&value, &scalar, sizeof(double));
+			return scope.Escape(Nan::New<v8::Number>(value));
+		}
+	}
+
+	return scope.Escape(MarshalCLRToV8(marshalData, payloadType));
+}
+
+v8::Local<v8::Value> CoreClrFunc::MarshalCLRToV8(MarshalReader* reader, int payloadType)
 {
 	Nan::EscapableHandleScope scope;
 
 	if (payloadType == V8TypeString)
 	{
-		return scope.Escape(Nan::New<v8::String>((char*)marshalData).ToLocalChecked());
+		return scope.Escape(reader->ReadString());
+	}
+
+	else if (payloadType == V8TypeExternalString)
+	{
+		int stringLength = reader->ReadInt32();
+		const uint16_t* chars = (const uint16_t*)reader->ReadPointer();
+		ReleaseBufferFunction release = (ReleaseBufferFunction)reader->ReadPointer();
+		void* releaseContext = reader->ReadPointer();
+
+		// The external string releases the pinned CLR string when it is collected
+		return scope.Escape(NewExternalString(chars, stringLength, release, releaseContext));
 	}
 
 	else if (payloadType == V8TypeInt32)
 	{
-		return scope.Escape(Nan::New<v8::Integer>(*(int*) marshalData));
+		return scope.Escape(Nan::New<v8::Integer>(reader->ReadInt32()));
 	}
 
 	else if (payloadType == V8TypeNumber)
 	{
-		return scope.Escape(Nan::New<v8::Number>(*(double*) marshalData));
+		return scope.Escape(Nan::New<v8::Number>(reader->ReadDouble()));
 	}
 
 	else if (payloadType == V8TypeDate)
 	{
-		return scope.Escape(Nan::New<v8::Date>(*(double*) marshalData).ToLocalChecked());
+		return scope.Escape(Nan::New<v8::Date>(reader->ReadDouble()).ToLocalChecked());
 	}
 
 	else if (payloadType == V8TypeBoolean)
 	{
-		bool value = (*(int*) marshalData) != 0;
+		bool value = reader->ReadInt32() != 0;
 		return scope.Escape(Nan::New<v8::Boolean>(value));
 	}
 
 	else if (payloadType == V8TypeArray)
 	{
-		V8ArrayData* arrayData = (V8ArrayData*) marshalData;
-		v8::Local<v8::Array> result = Nan::New<v8::Array>();
+		int arrayLength = reader->ReadInt32();
+		v8::Local<v8::Array> result = Nan::New<v8::Array>(arrayLength);
 
-		for (int i = 0; i < arrayData->arrayLength; i++)
+		for (int i = 0; i < arrayLength; i++)
 		{
-			result->Set(i, MarshalCLRToV8(arrayData->itemValues[i], arrayData->itemTypes[i]));
+			int itemType = reader->ReadInt32();
+			result->Set(i, MarshalCLRToV8(reader, itemType));
+		}
+
+		return scope.Escape(result);
+	}
+
+	else if (payloadType == V8TypePackedArray)
+	{
+		int itemType = reader->ReadInt32();
+		int arrayLength = reader->ReadInt32();
+		std::vector<v8::Local<v8::Value>> items(arrayLength);
+
+		for (int i = 0; i < arrayLength; i++)
+		{
+			switch (itemType)
+			{
+				case V8TypeInt32:
+					items[i] = Nan::New<v8::Integer>(reader->ReadInt32());
+					break;
+				case V8TypeNumber:
+					items[i] = Nan::New<v8::Number>(reader->ReadDouble());
+					break;
+				case V8TypeBoolean:
+					items[i] = Nan::New<v8::Boolean>(reader->ReadInt32() != 0);
+					break;
+				default:
+					items[i] = reader->ReadString();
+					break;
+			}
+		}
+
+#if NODE_MAJOR_VERSION >= 12
+		return scope.Escape(v8::Array::New(v8::Isolate::GetCurrent(), items.data(), arrayLength));
+#else
+		v8::Local<v8::Array> result = Nan::New<v8::Array>(arrayLength);
+
+		for (int i = 0; i < arrayLength; i++)
+		{
+			result->Set(i, items[i]);
+		}
+
+		return scope.Escape(result);
+#endif
+	}
+
+	else if (payloadType == V8TypeShapedObject)
+	{
+		CoreClrObjectShape* shape = GetObjectShape(reader->ReadPointer());
+		v8::Local<v8::Object> result = Nan::NewInstance(Nan::New(shape->objectTemplate)).ToLocalChecked();
+
+		for (int i = 0; i < shape->propertyCount; i++)
+		{
+			int propertyType = reader->ReadInt32();
+			result->Set(Nan::New(shape->propertyNames[i]), MarshalCLRToV8(reader, propertyType));
 		}
 
 		return scope.Escape(result);
@@ -461,12 +988,15 @@ v8::Local<v8::Value> CoreClrFunc::MarshalCLRToV8(void* marshalData, int payloadT
 
 	else if (payloadType == V8TypeObject || payloadType == V8TypeException)
 	{
-		V8ObjectData* objectData = (V8ObjectData*) marshalData;
+		int propertiesCount = reader->ReadInt32();
 		v8::Local<v8::Object> result = Nan::New<v8::Object>();
 
-		for (int i = 0; i < objectData->propertiesCount; i++)
+		for (int i = 0; i < propertiesCount; i++)
 		{
-			result->Set(Nan::New<v8::String>(objectData->propertyNames[i]).ToLocalChecked(), MarshalCLRToV8(objectData->propertyData[i], objectData->propertyTypes[i]));
+			v8::Local<v8::String> name = reader->ReadString();
+			int propertyType = reader->ReadInt32();
+
+			result->Set(name, MarshalCLRToV8(reader, propertyType));
 		}
 
 		if (payloadType == V8TypeException)
@@ -489,11 +1019,11 @@ v8::Local<v8::Value> CoreClrFunc::MarshalCLRToV8(void* marshalData, int payloadT
 
 	else if (payloadType == V8TypeBuffer)
 	{
-		V8BufferData* bufferData = (V8BufferData*) marshalData;
+		int bufferLength = reader->ReadInt32();
 
-		if (bufferData->bufferLength > 0)
+		if (bufferLength > 0)
 		{
-			return scope.Escape(Nan::CopyBuffer(bufferData->buffer, bufferData->bufferLength).ToLocalChecked());
+			return scope.Escape(Nan::CopyBuffer(reader->ReadBytes(bufferLength), bufferLength).ToLocalChecked());
 		}
 
 		else
@@ -502,9 +1032,29 @@ v8::Local<v8::Value> CoreClrFunc::MarshalCLRToV8(void* marshalData, int payloadT
 		}
 	}
 
+	else if (payloadType == V8TypeBufferView)
+	{
+		int bufferLength = reader->ReadInt32();
+		char* buffer = (char*)reader->ReadPointer();
+		ReleaseBufferFunction release = (ReleaseBufferFunction)reader->ReadPointer();
+		void* releaseContext = reader->ReadPointer();
+
+		// The node.js Buffer releases the pinned CLR memory when it is collected
+		return scope.Escape(NewExternalBuffer(buffer, bufferLength, release, releaseContext));
+	}
+
+	else if (payloadType == V8TypeTypedArray)
+	{
+		TypedArrayType arrayType = (TypedArrayType)reader->ReadInt32();
+		int arrayLength = reader->ReadInt32();
+		const char* elements = reader->ReadBytes(arrayLength * GetTypedArrayElementSize(arrayType));
+
+		return scope.Escape(NewTypedArray(arrayType, elements, arrayLength));
+	}
+
 	else if (payloadType == V8TypeFunction)
 	{
-		return scope.Escape(InitializeInstance(marshalData));
+		return scope.Escape(InitializeInstance(reader->ReadPointer()));
 	}
 
 	else
@@ -1,33 +1,71 @@
 #include "edge.h"
 
-CoreClrFuncInvokeContext::CoreClrFuncInvokeContext(v8::Local<v8::Value> callback, void* task) : task(task), uv_edge_async(NULL), resultData(NULL), resultType(0)
+static std::vector<CoreClrFuncInvokeContext*> freeInvokeContexts;
+
+CoreClrFuncInvokeContext::CoreClrFuncInvokeContext() : uv_edge_async(NULL), resultData(NULL), resultType(0), resultScalar(0), taskState(0)
 {
     DBG("CoreClrFuncInvokeContext::CoreClrFuncInvokeContext");
+}
+
+CoreClrFuncInvokeContext* CoreClrFuncInvokeContext::Acquire(v8::Local<v8::Value> callback, v8::Local<v8::Promise::Resolver> resolver)
+{
+	DBG("CoreClrFuncInvokeContext::Acquire");
+
+	CoreClrFuncInvokeContext* context;
+
+	if (freeInvokeContexts.empty())
+	{
+		context = new CoreClrFuncInvokeContext();
+	}
 
-    this->callback = new Nan::Callback(v8::Local<v8::Function>::Cast(callback));
+	else
+	{
+		context = freeInvokeContexts.back();
+		freeInvokeContexts.pop_back();
+	}
+
+	// Calls made without a callback or promise are fire-and-forget, both stay empty
+	if (!resolver.IsEmpty())
+	{
+		context->resolver.Reset(resolver);
+	}
+
+	else if (callback->IsFunction())
+	{
+		context->callback.Reset(v8::Local<v8::Function>::Cast(callback));
+	}
+
+	return context;
 }
 
-CoreClrFuncInvokeContext::~CoreClrFuncInvokeContext()
+void CoreClrFuncInvokeContext::Release(CoreClrFuncInvokeContext* context)
 {
-	DBG("CoreClrFuncInvokeContext::~CoreClrFuncInvokeContext");
+	DBG("CoreClrFuncInvokeContext::Release");
 
-    if (this->callback)
+    context->callback.Reset();
+    context->resolver.Reset();
+    context->payload.Reset();
+
+    if (context->resultData)
     {
-        this->callback->Reset();
-        delete this->callback;
-        this->callback = NULL;
+    	// Results of calls nobody waits for are dropped without being read
+    	CoreClrFunc::FreeUnreadMarshalData(context->resultData, context->resultType);
+    	context->resultData = NULL;
     }
 
-    if (this->task)
+    context->uv_edge_async = NULL;
+    context->resultType = 0;
+    context->resultScalar = 0;
+    context->taskState = 0;
+
+    if (freeInvokeContexts.size() < EDGE_MAX_POOLED_INVOKE_CONTEXTS)
     {
-    	CoreClrEmbedding::FreeHandle(this->task);
-    	this->task = NULL;
+    	freeInvokeContexts.push_back(context);
     }
 
-    if (this->resultData)
+    else
     {
-    	CoreClrEmbedding::FreeMarshalData(this->resultData, this->resultType);
-    	this->resultData = NULL;
+    	delete context;
     }
 }
 
@@ -37,6 +75,74 @@ void CoreClrFuncInvokeContext::InitializeAsyncOperation()
     this->uv_edge_async = V8SynchronizationContext::RegisterAction(CoreClrFuncInvokeContext::InvokeCallback, this);
 }
 
+void CoreClrFuncInvokeContext::KeepAlive(v8::Local<v8::Value> payload)
+{
+	// Buffers passed to the CLR as views must not be collected before the call completes
+	this->payload.Reset(payload);
+}
+
+void CoreClrFuncInvokeContext::Offload(CoreClrFunc* function, CoreClrGcHandle functionHandle, void* payload, int payloadType, int64_t scalarPayload)
+{
+	DBG("CoreClrFuncInvokeContext::Offload");
+
+	// The function handle must stay valid until the thread pool is done with it, even if the proxy is disposed
+	function->AddRef();
+
+	CoreClrFuncOffloadData* offloadData = new CoreClrFuncOffloadData;
+	offloadData->request.data = offloadData;
+	offloadData->function = function;
+	offloadData->functionHandle = functionHandle;
+	offloadData->payload = payload;
+	offloadData->payloadType = payloadType;
+	offloadData->scalarPayload = scalarPayload;
+	offloadData->context = this;
+
+	uv_queue_work(uv_default_loop(), &offloadData->request, CoreClrFuncInvokeContext::OffloadWork, CoreClrFuncInvokeContext::OffloadComplete);
+}
+
+void CoreClrFuncInvokeContext::OffloadWork(uv_work_t* request)
+{
+	// This executes on a thread pool thread
+
+	DBG("CoreClrFuncInvokeContext::OffloadWork");
+
+	CoreClrFuncOffloadData* offloadData = (CoreClrFuncOffloadData*)request->data;
+	CoreClrFuncInvokeContext* context = offloadData->context;
+	int taskState;
+	void* result;
+	int resultType;
+
+	CoreClrEmbedding::CallClrFunc(offloadData->functionHandle, offloadData->payload, offloadData->payloadType, offloadData->scalarPayload,
+		&taskState, &result, &resultType, &context->resultScalar);
+	CoreClrFunc::FreeMarshalData(offloadData->payload, offloadData->payloadType);
+	offloadData->payload = NULL;
+
+	if (taskState == TaskStatusRanToCompletion || taskState == TaskStatusFaulted)
+	{
+		TaskComplete(result, resultType, taskState, context);
+		return;
+	}
+
+	// The CLR releases the task handle once it has registered the continuation
+	void* exception;
+	CoreClrEmbedding::ContinueTask(result, context, &exception);
+
+	if (exception)
+	{
+		TaskComplete(exception, V8TypeException, TaskStatusFaulted, context);
+	}
+}
+
+void CoreClrFuncInvokeContext::OffloadComplete(uv_work_t* request, int status)
+{
+	// The invoke context completes through TaskComplete, this only releases the work request
+
+	DBG("CoreClrFuncInvokeContext::OffloadComplete");
+	CoreClrFuncOffloadData* offloadData = (CoreClrFuncOffloadData*)request->data;
+	CoreClrFunc::Release(offloadData->function);
+	delete offloadData;
+}
+
 void CoreClrFuncInvokeContext::TaskComplete(void* result, int resultType, int taskState, CoreClrFuncInvokeContext* context)
 {
 	DBG("CoreClrFuncInvokeContext::TaskComplete");
@@ -48,14 +154,15 @@ void CoreClrFuncInvokeContext::TaskComplete(void* result, int resultType, int ta
 	V8SynchronizationContext::ExecuteAction(context->uv_edge_async);
 }
 
-void CoreClrFuncInvokeContext::TaskCompleteSynchronous(void* result, int resultType, int taskState, v8::Local<v8::Value> callback)
+void CoreClrFuncInvokeContext::TaskCompleteSynchronous(void* result, int resultType, int64_t resultScalar, int taskState, v8::Local<v8::Value> callback)
 {
 	DBG("CoreClrFuncInvokeContext::TaskCompleteSynchronous");
 
-	CoreClrFuncInvokeContext* context = new CoreClrFuncInvokeContext(callback, NULL);
+	CoreClrFuncInvokeContext* context = Acquire(callback, v8::Local<v8::Promise::Resolver>());
 
 	context->resultData = result;
 	context->resultType = resultType;
+	context->resultScalar = resultScalar;
 	context->taskState = taskState;
 
 	InvokeCallback(context);
@@ -66,6 +173,14 @@ void CoreClrFuncInvokeContext::InvokeCallback(void* data)
 	DBG("CoreClrFuncInvokeContext::InvokeCallback");
 
 	CoreClrFuncInvokeContext* context = (CoreClrFuncInvokeContext*)data;
+
+	if (context->resolver.IsEmpty() && context->callback.IsEmpty())
+	{
+		DBG("CoreClrFuncInvokeContext::InvokeCallback - No callback to call");
+		Release(context);
+		return;
+	}
+
 	v8::Local<v8::Value> callbackData = Nan::Null();
 	v8::Local<v8::Value> errors = Nan::Null();
 
@@ -76,19 +191,44 @@ void CoreClrFuncInvokeContext::InvokeCallback(void* data)
 
 	else
 	{
-		callbackData = CoreClrFunc::MarshalCLRToV8(context->resultData, context->resultType);
+		callbackData = CoreClrFunc::MarshalCLRToV8(context->resultData, context->resultType, context->resultScalar);
 	}
 
+	CoreClrFunc::FreeMarshalData(context->resultData, context->resultType);
+	context->resultData = NULL;
+
 	DBG("CoreClrFuncInvokeContext::InvokeCallback - Marshalling complete");
 
+	if (!context->resolver.IsEmpty())
+	{
+		// Promises are only completed here for calls that did not complete synchronously
+		DBG("CoreClrFuncInvokeContext::InvokeCallback - completing promise");
+		v8::Local<v8::Promise::Resolver> resolver = Nan::New(context->resolver);
+		bool faulted = context->taskState == TaskStatusFaulted;
+		Release(context);
+
+		if (!faulted)
+		{
+			resolver->Resolve(Nan::GetCurrentContext(), callbackData).FromJust();
+		}
+
+		else
+		{
+			resolver->Reject(Nan::GetCurrentContext(), errors).FromJust();
+		}
+
+		CallbackHelper::KickNextTick();
+		return;
+	}
+
 	v8::Local<Value> argv[] = { errors, callbackData };
 	int argc = 2;	
 
 	Nan::TryCatch tryCatch;
 
     DBG("CoreClrFuncInvokeContext::InvokeCallback - calling JS callback");
-    context->callback->Call(argc, argv);
-    delete context;
+    context->callback.Call(argc, argv);
+    Release(context);
     if (tryCatch.HasCaught())
     {
         DBG("CoreClrFuncInvokeContext::InvokeCallback - exception in callback");
@@ -1,11 +1,18 @@
 #include "edge.h"
 
-CoreClrNodejsFunc::CoreClrNodejsFunc(v8::Local<v8::Function> function)
+// Functions released by the CLR wait in a lock-free stack until the V8 thread deletes them. The release
+// that finds the stack empty schedules the V8 thread to take all releases queued up to that point at once.
+static CoreClrNodejsFunc* volatile queuedReleases = NULL;
+
+int CoreClrNodejsFunc::liveCount = 0;
+
+CoreClrNodejsFunc::CoreClrNodejsFunc(v8::Local<v8::Function> function) : nextRelease(NULL)
 {
     DBG("CoreClrNodejsFunc::CoreClrNodejsFunc");
 
     this->Func = new Nan::Persistent<v8::Function>;
     this->Func->Reset(function);
+    liveCount++;
 }
 
 CoreClrNodejsFunc::~CoreClrNodejsFunc()
@@ -14,6 +21,7 @@ CoreClrNodejsFunc::~CoreClrNodejsFunc()
 	this->Func->Reset();
     delete this->Func;
 	this->Func = NULL;
+	liveCount--;
 }
 
 void CoreClrNodejsFunc::Release(CoreClrNodejsFunc* function)
@@ -22,6 +30,56 @@ void CoreClrNodejsFunc::Release(CoreClrNodejsFunc* function)
 	delete function;
 }
 
+void CoreClrNodejsFunc::QueueRelease(CoreClrNodejsFunc* function)
+{
+	// This executes on the CLR finalizer thread
+
+	DBG("CoreClrNodejsFunc::QueueRelease");
+
+	CoreClrNodejsFunc* head;
+
+	do
+	{
+		head = queuedReleases;
+		function->nextRelease = head;
+	}
+#ifdef _WIN32
+	while (InterlockedCompareExchangePointer((PVOID volatile*)&queuedReleases, function, head) != head);
+#else
+	while (!__atomic_compare_exchange_n(&queuedReleases, &head, function, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+#endif
+
+	if (!head)
+	{
+		V8SynchronizationContext::ExecuteAction(V8SynchronizationContext::RegisterAction(CoreClrNodejsFunc::ReleaseQueued, NULL));
+	}
+}
+
+void CoreClrNodejsFunc::ReleaseQueued(void* data)
+{
+	// This executes on V8 thread
+
+#ifdef _WIN32
+	CoreClrNodejsFunc* function = (CoreClrNodejsFunc*)InterlockedExchangePointer((PVOID volatile*)&queuedReleases, NULL);
+#else
+	CoreClrNodejsFunc* function = __atomic_exchange_n(&queuedReleases, (CoreClrNodejsFunc*)NULL, __ATOMIC_ACQUIRE);
+#endif
+
+	DBG("CoreClrNodejsFunc::ReleaseQueued");
+
+	while (function)
+	{
+		CoreClrNodejsFunc* next = function->nextRelease;
+		Release(function);
+		function = next;
+	}
+}
+
+int CoreClrNodejsFunc::GetLiveCount()
+{
+	return liveCount;
+}
+
 void CoreClrNodejsFunc::Call(void* payload, int payloadType, CoreClrNodejsFunc* functionContext, CoreClrGcHandle callbackContext, NodejsFuncCompleteFunction callbackFunction)
 {
 	DBG("CoreClrNodejsFunc::Call");
@@ -1,33 +1,5 @@
 #include "edge.h"
 
-NAN_METHOD(coreClrV8FuncCallback)
-{
-    DBG("coreClrV8FuncCallback");
-
-    Nan::HandleScope scope;
-    v8::Local<v8::External> correlator = v8::Local<v8::External>::Cast(info[2]);
-    CoreClrNodejsFuncInvokeContext* context = (CoreClrNodejsFuncInvokeContext*)(correlator->Value());
-
-    if (!info[0]->IsUndefined() && !info[0]->IsNull())
-    {
-    	void* clrExceptionData;
-    	CoreClrFunc::MarshalV8ExceptionToCLR(info[0], &clrExceptionData);
-
-        context->Complete(TaskStatusFaulted, clrExceptionData, V8TypeException);
-    }
-
-    else
-    {
-    	void* marshalData;
-    	int payloadType;
-
-        CoreClrFunc::MarshalV8ToCLR(info[1], &marshalData, &payloadType);
-        context->Complete(TaskStatusRanToCompletion, marshalData, payloadType);
-    }
-
-    info.GetReturnValue().SetUndefined();
-}
-
 CoreClrNodejsFuncInvokeContext::CoreClrNodejsFuncInvokeContext(void* payload, int payloadType, CoreClrNodejsFunc* functionContext, CoreClrGcHandle callbackContext, NodejsFuncCompleteFunction callbackFunction)
 {
 	DBG("CoreClrNodejsFuncInvokeContext::CoreClrNodejsFuncInvokeContext");
@@ -42,14 +14,9 @@ CoreClrNodejsFuncInvokeContext::CoreClrNodejsFuncInvokeContext(void* payload, in
 
 CoreClrNodejsFuncInvokeContext::~CoreClrNodejsFuncInvokeContext()
 {
-	if (uv_edge_async)
-	{
-		delete uv_edge_async;
-	}
-
 	if (Payload)
 	{
-		CoreClrFunc::FreeMarshalData(Payload, PayloadType);
+		CoreClrFunc::FreeUnreadMarshalData(Payload, PayloadType);
 	}
 }
 
@@ -57,10 +24,23 @@ void CoreClrNodejsFuncInvokeContext::Complete(TaskStatus taskStatus, void* resul
 {
 	DBG("CoreClrNodejsFuncInvokeContext::Complete");
 	CallbackFunction(CallbackContext, taskStatus, result, resultType);
+
+	// The CLR has finished reading the result by the time the callback returns
+	CoreClrFunc::FreeMarshalData(result, resultType);
+	delete this;
 }
 
 void CoreClrNodejsFuncInvokeContext::Invoke()
 {
+	if (V8SynchronizationContext::IsOnV8Thread())
+	{
+		// .NET code running synchronously on V8 thread calls the function right away instead of waiting for
+		// the next turn of the event loop. Ticks are processed once control returns to the JavaScript caller.
+		DBG("CoreClrNodejsFuncInvokeContext::Invoke - Calling JavaScript function inline");
+		this->CallFunction();
+		return;
+	}
+
 	this->uv_edge_async = V8SynchronizationContext::RegisterAction(CoreClrNodejsFuncInvokeContext::InvokeCallback, this);
 	V8SynchronizationContext::ExecuteAction(uv_edge_async);
 }
@@ -70,49 +50,44 @@ void CoreClrNodejsFuncInvokeContext::InvokeCallback(void* data)
 	DBG("CoreClrNodejsFuncInvokeContext::InvokeCallback");
 
 	CoreClrNodejsFuncInvokeContext* context = (CoreClrNodejsFuncInvokeContext*) data;
-	v8::Local<v8::Value> v8Payload = CoreClrFunc::MarshalCLRToV8(context->Payload, context->PayloadType);
+	context->CallFunction();
 
-	static Nan::Persistent<v8::Function> callbackFactory;
-	static Nan::Persistent<v8::Function> callbackFunction;
+	// Kick the next tick
+	CallbackHelper::KickNextTick();
+}
 
+void CoreClrNodejsFuncInvokeContext::CallFunction()
+{
 	Nan::HandleScope scope;
+	v8::Local<v8::Value> v8Payload = CoreClrFunc::MarshalCLRToV8(Payload, PayloadType);
+	v8::Local<v8::Function> func = Nan::New(*(FunctionContext->Func));
 
-	// See https://github.com/tjanczuk/edge/issues/125 for context
-	if (callbackFactory.IsEmpty())
-	{
-		v8::Local<v8::Function> v8FuncCallbackFunction = Nan::New<v8::FunctionTemplate>(coreClrV8FuncCallback)->GetFunction();
-		callbackFunction.Reset(v8FuncCallbackFunction);
-		v8::Local<v8::String> code = Nan::New<v8::String>(
-			"(function (cb, ctx) { return function (e, d) { return cb(e, d, ctx); }; })").ToLocalChecked();
-		v8::Local<v8::Function> callbackFactoryFunction = v8::Local<v8::Function>::Cast(v8::Script::Compile(code)->Run());
-		callbackFactory.Reset(callbackFactoryFunction);
-	}
+	CoreClrFunc::FreeMarshalData(Payload, PayloadType);
+	Payload = NULL;
 
-	v8::Local<v8::Value> factoryArgv[] = { Nan::New(callbackFunction), Nan::New<v8::External>((void*)context) };
-	v8::Local<v8::Function> callback = v8::Local<v8::Function>::Cast(
-		Nan::New(callbackFactory)->Call(Nan::GetCurrentContext()->Global(), 2, factoryArgv));
+	// The context may be deleted before this returns, if the function completes synchronously
+	NodejsFuncCompletion::Invoke(func, v8Payload, this, CoreClrNodejsFuncInvokeContext::CompleteCallback);
+}
 
-	v8::Local<v8::Value> argv[] = { v8Payload, callback };
-	TryCatch tryCatch;
+void CoreClrNodejsFuncInvokeContext::CompleteCallback(void* data, bool faulted, v8::Local<v8::Value> value)
+{
+	DBG("CoreClrNodejsFuncInvokeContext::CompleteCallback");
 
-	DBG("CoreClrNodejsFuncInvokeContext::InvokeCallback - Calling JavaScript function");
-	Nan::Call(Nan::New(*(context->FunctionContext->Func)), Nan::GetCurrentContext()->Global(), 2, argv);
-	DBG("CoreClrNodejsFuncInvokeContext::InvokeCallback - Called JavaScript function");
+	CoreClrNodejsFuncInvokeContext* context = (CoreClrNodejsFuncInvokeContext*) data;
 
-	if (tryCatch.HasCaught())
+	if (faulted)
 	{
-		DBG("CoreClrNodejsFuncInvokeContext::InvokeCallback - Caught JavaScript exception");
-
 		void* exceptionData;
-		CoreClrFunc::MarshalV8ExceptionToCLR(tryCatch.Exception(), &exceptionData);
-
-		DBG("CoreClrNodejsFuncInvokeContext::InvokeCallback - Exception message is: %s", (char*)exceptionData);
+		CoreClrFunc::MarshalV8ExceptionToCLR(value, &exceptionData);
 
 		context->Complete(TaskStatusFaulted, exceptionData, V8TypeException);
 	}
-    else
-    {
-        // Kick the next tick
-        CallbackHelper::KickNextTick();
-    }
+	else
+	{
+		void* marshalData;
+		int payloadType;
+
+		CoreClrFunc::MarshalV8ToCLR(value, &marshalData, &payloadType);
+		context->Complete(TaskStatusRanToCompletion, marshalData, payloadType);
+	}
 }
@@ -9,6 +9,8 @@
 #include <stdio.h>
 #include <utility>
 #include <map>
+#include <vector>
+#include <unordered_map>
 
 #include "pal/pal.h"
 
@@ -22,28 +24,49 @@ typedef int32_t HRESULT;
 #endif
 
 typedef void* CoreClrGcHandle;
+typedef void* (STDMETHODCALLTYPE *AllocMarshalBlockFunction)(size_t size);
+typedef void* (STDMETHODCALLTYPE *ReallocMarshalBlockFunction)(void* block, size_t size);
+typedef void (STDMETHODCALLTYPE *FreeMarshalBlockFunction)(void* block);
+
+class CoreClrFunc;
+class CoreClrFuncInvokeContext;
+class CoreClrNodejsFunc;
+
+typedef void (*TaskCompleteFunction)(void* result, int resultType, int taskState, CoreClrFuncInvokeContext* context);
+typedef void (*ReleaseV8FunctionFunction)(CoreClrNodejsFunc* function);
 
 typedef struct bootstrapperContext
 {
 	const char* runtimeDirectory;
 	const char* applicationDirectory;
 	const char* dependencyManifestFile;
+	AllocMarshalBlockFunction allocMarshalBlock;
+	ReallocMarshalBlockFunction reallocMarshalBlock;
+	FreeMarshalBlockFunction freeMarshalBlock;
+	TaskCompleteFunction taskComplete;
+	ReleaseV8FunctionFunction releaseV8Function;
+	int minExternalStringLength;
+	BOOL pinByteArrays;
 } BootstrapperContext;
 
+// Null, Boolean, Int32, UInt32 and Number payloads, and results of the same types that are available
+// synchronously, are passed by value in a 64-bit slot next to a NULL data pointer: integers and booleans
+// as int64, numbers as the bits of the double.
 typedef void (STDMETHODCALLTYPE *CallFuncFunction)(
 		CoreClrGcHandle functionHandle,
 		void* payload,
 		int payloadType,
+		int64_t scalarPayload,
 		int* taskState,
 		void** result,
-		int* resultType);
+		int* resultType,
+		int64_t* scalarResult);
 typedef CoreClrGcHandle (STDMETHODCALLTYPE *GetFuncFunction)(
 		const char* assemblyFile,
 		const char* typeName,
 		const char* methodName,
 		void** exception);
 typedef void (STDMETHODCALLTYPE *FreeHandleFunction)(CoreClrGcHandle handle);
-typedef void (STDMETHODCALLTYPE *FreeMarshalDataFunction)(void* marshalData, int marshalDataType);
 typedef void (STDMETHODCALLTYPE *NodejsFuncCompleteFunction)(CoreClrGcHandle context, int taskStatus, void* result, int resultType);
 typedef CoreClrGcHandle (STDMETHODCALLTYPE *CompileFuncFunction)(
         const void* options,
@@ -65,35 +88,57 @@ typedef enum v8Type
     V8TypeNumber = 10,
     V8TypeNull = 11,
     V8TypeTask = 12,
-    V8TypeException = 13
+    V8TypeException = 13,
+    V8TypeBufferView = 14,
+    V8TypeExternalString = 15,
+    V8TypeTypedArray = 16,
+    V8TypePackedArray = 17,
+    V8TypeShapedObject = 18
 } V8Type;
 
+typedef struct coreClrFuncOffloadData
+{
+	uv_work_t request;
+	CoreClrFunc* function;
+	CoreClrGcHandle functionHandle;
+	void* payload;
+	int payloadType;
+	int64_t scalarPayload;
+	CoreClrFuncInvokeContext* context;
+} CoreClrFuncOffloadData;
+
+// Invoke contexts are acquired and released on the V8 thread, released contexts are pooled for later calls
 class CoreClrFuncInvokeContext
 {
 	private:
-		Nan::Callback* callback;
-		CoreClrGcHandle task;
+		Nan::Callback callback;
+		Nan::Persistent<v8::Promise::Resolver> resolver;
 		uv_edge_async_t* uv_edge_async;
+		Nan::Persistent<v8::Value> payload;
 		void* resultData;
 		int resultType;
+		int64_t resultScalar;
 		int taskState;
 
-	public:
-		bool Sync();
-		void Sync(bool value);
+		CoreClrFuncInvokeContext();
 
-		CoreClrFuncInvokeContext(v8::Local<v8::Value> callback, void* task);
-		~CoreClrFuncInvokeContext();
+		static void OffloadWork(uv_work_t* request);
+		static void OffloadComplete(uv_work_t* request, int status);
+
+	public:
+		static CoreClrFuncInvokeContext* Acquire(v8::Local<v8::Value> callback, v8::Local<v8::Promise::Resolver> resolver);
+		static void Release(CoreClrFuncInvokeContext* context);
 
 		void InitializeAsyncOperation();
+		void KeepAlive(v8::Local<v8::Value> payload);
+		void Offload(CoreClrFunc* function, CoreClrGcHandle functionHandle, void* payload, int payloadType, int64_t scalarPayload);
 
 		static void TaskComplete(void* result, int resultType, int taskState, CoreClrFuncInvokeContext* context);
-		static void TaskCompleteSynchronous(void* result, int resultType, int taskState, v8::Local<v8::Value> callback);
+		static void TaskCompleteSynchronous(void* result, int resultType, int64_t resultScalar, int taskState, v8::Local<v8::Value> callback);
 		static void InvokeCallback(void* data);
 };
 
-typedef void (*TaskCompleteFunction)(void* result, int resultType, int taskState, CoreClrFuncInvokeContext* context);
-typedef void (STDMETHODCALLTYPE *ContinueTaskFunction)(void* task, void* context, TaskCompleteFunction callback, void** exception);
+typedef void (STDMETHODCALLTYPE *ContinueTaskFunction)(void* task, void* context, void** exception);
 
 class CoreClrEmbedding
 {
@@ -102,35 +147,141 @@ class CoreClrEmbedding
 
     public:
         static CoreClrGcHandle GetClrFuncReflectionWrapFunc(const char* assemblyFile, const char* typeName, const char* methodName, v8::Local<v8::Value>* exception);
-        static void CallClrFunc(CoreClrGcHandle functionHandle, void* payload, int payloadType, int* taskState, void** result, int* resultType);
+        static void CallClrFunc(CoreClrGcHandle functionHandle, void* payload, int payloadType, int64_t scalarPayload, int* taskState, void** result, int* resultType, int64_t* scalarResult);
         static HRESULT Initialize(BOOL debugMode);
-        static void ContinueTask(CoreClrGcHandle taskHandle, void* context, TaskCompleteFunction callback, void** exception);
+        static void ContinueTask(CoreClrGcHandle taskHandle, void* context, void** exception);
         static void FreeHandle(CoreClrGcHandle handle);
-        static void FreeMarshalData(void* marshalData, int marshalDataType);
         static CoreClrGcHandle CompileFunc(const void* options, const int payloadType, v8::Local<v8::Value>* exception);
 };
 
+// Values are marshaled between V8 and the CLR as a single contiguous block. The type of the root value
+// is passed next to the block, nested values are prefixed with their int32 V8Type tag. Value layouts:
+//   String, property name:      int32 character count << 1 (| 1 for Latin-1), Latin-1 bytes or UTF-16 code units
+//   Int32, UInt32, Boolean:     int32
+//   Number, Date:               double
+//   Null:                       nothing (a Null root is passed as a NULL pointer)
+// Scalar roots of calls to CLR functions and of their synchronous results are passed by value, see CallFuncFunction.
+//   Buffer:                     int32 byte count, bytes
+//   BufferView:                 int32 byte count, buffer pointer, release function pointer, release context
+//   ExternalString:             int32 character count, UTF-16 pointer, release function pointer, release context
+//   TypedArray:                 int32 TypedArrayType, int32 element count, elements
+//   Function:                   CoreClrNodejsFunc* or GCHandle of the CLR function
+//   Array:                      int32 item count, tagged items
+//   PackedArray:                int32 V8Type of the items (Int32, Number, Boolean or String), int32 item count, untagged items
+//   Object, CLR Exception:      int32 property count, (property name, tagged value) pairs
+//   V8 property name:           String, or int32 -1 and a pointer to a cached name record
+//   Cached name record:         pointer slot for the CLR string handle, name String; allocated once and never freed
+//   ShapedObject:               shape descriptor pointer, tagged values in the order of the shape's property names
+//   Shape descriptor:           int32 property count, property names; allocated once per CLR type and never freed
+//   V8 Exception:               same as String
+// The reader of a BufferView or ExternalString owns its release function. Blocks the CLR wrote that are
+// dropped without being read are freed with CoreClrFunc::FreeUnreadMarshalData, which calls it instead.
+// Blocks written by either side are allocated with AllocMarshalBlock and released with FreeMarshalBlock.
+void* STDMETHODCALLTYPE AllocMarshalBlock(size_t size);
+void* STDMETHODCALLTYPE ReallocMarshalBlock(void* block, size_t size);
+void STDMETHODCALLTYPE FreeMarshalBlock(void* block);
+
+class MarshalWriter
+{
+	private:
+		char* data;
+		size_t length;
+		size_t capacity;
+
+	public:
+		MarshalWriter();
+		~MarshalWriter();
+
+		char* Detach();
+		char* Reserve(size_t size);
+		size_t ReserveInt32();
+		void WriteInt32At(size_t offset, int32_t value);
+		void WriteInt32(int32_t value);
+		void WriteDouble(double value);
+		void WritePointer(void* value);
+		void WriteString(v8::Local<v8::String> value);
+};
+
+class MarshalReader
+{
+	private:
+		const char* position;
+
+	public:
+		MarshalReader(const void* data);
+
+		int32_t ReadInt32();
+		double ReadDouble();
+		void* ReadPointer();
+		const char* ReadBytes(size_t length);
+		v8::Local<v8::String> ReadString(v8::NewStringType type = v8::NewStringType::kNormal);
+};
+
+// Property names of a CLR type returned to V8, cached on the V8 thread for the shape descriptor sent by the CLR.
+// Objects of the same shape are created from one ObjectTemplate, so they share a hidden class.
+typedef struct coreClrObjectShape
+{
+	int propertyCount;
+	Nan::Persistent<v8::String>* propertyNames;
+	Nan::Persistent<v8::ObjectTemplate> objectTemplate;
+} CoreClrObjectShape;
+
+// Property name of JavaScript objects passed to the CLR and the name record the CLR caches its string in
+typedef struct coreClrPropertyName
+{
+	Nan::Persistent<v8::String> name;
+	void* record;
+} CoreClrPropertyName;
+
 class CoreClrFunc
 {
 	private:
 		CoreClrGcHandle functionHandle;
+		bool offload;
+		bool promise;
+		BufferMarshalMode bufferMode;
+
+		int references;
+
+		static int liveCount;
 
 		CoreClrFunc();
+		~CoreClrFunc();
 
-		static char* CopyV8StringBytes(v8::Local<v8::String> v8String);
-		static v8::Local<v8::Function> InitializeInstance(CoreClrGcHandle functionHandle);
+		static v8::Local<v8::Function> InitializeInstance(CoreClrGcHandle functionHandle, bool offload = false, bool promise = false, BufferMarshalMode bufferMode = BufferMarshalModeCopy);
+		static int MarshalV8ToCLR(MarshalWriter* writer, v8::Local<v8::Value> jsdata, BufferMarshalMode bufferMode);
+		static int GetPackedArrayType(v8::Local<v8::Array> jsarray, unsigned int arrayLength);
+		static CoreClrObjectShape* GetObjectShape(const void* shapeDescriptor);
+		static void WritePropertyName(MarshalWriter* writer, v8::Local<v8::String> name);
+		static v8::Local<v8::Value> MarshalCLRToV8(MarshalReader* reader, int payloadType);
+		static void ReleaseUnreadMarshalData(MarshalReader* reader, int payloadType);
 
 	public:
+		// The proxy owns a reference to the function, offloaded calls hold another one until they complete
+		void AddRef();
+		static void Release(CoreClrFunc* function);
+
 		static NAN_METHOD(Initialize);
+		static int GetLiveCount();
 		v8::Local<v8::Value> Call(v8::Local<v8::Value> payload, v8::Local<v8::Value> callbackOrSync);
 		static void FreeMarshalData(void* marshalData, int payloadType);
-		static void MarshalV8ToCLR(v8::Local<v8::Value> jsdata, void** marshalData, int* payloadType);
+		static void FreeUnreadMarshalData(void* marshalData, int payloadType);
+		static void MarshalV8ToCLR(v8::Local<v8::Value> jsdata, void** marshalData, int* payloadType, BufferMarshalMode bufferMode = BufferMarshalModeCopy);
+		static bool MarshalV8ToCLRScalar(v8::Local<v8::Value> jsdata, int64_t* scalar, int* payloadType);
 		static v8::Local<v8::Value> MarshalCLRToV8(void* marshalData, int payloadType);
+		static v8::Local<v8::Value> MarshalCLRToV8(void* marshalData, int payloadType, int64_t scalar);
 		static void MarshalV8ExceptionToCLR(v8::Local<v8::Value> exception, void** marshalData);
 };
 
 class CoreClrNodejsFunc
 {
+	private:
+		static int liveCount;
+
+		CoreClrNodejsFunc* nextRelease;
+
+		static void ReleaseQueued(void* data);
+
 	public:
 		Nan::Persistent<Function>* Func;
 
@@ -139,6 +290,8 @@ class CoreClrNodejsFunc
 
 		static void Call(void* payload, int payloadType, CoreClrNodejsFunc* functionContext, CoreClrGcHandle callbackContext, NodejsFuncCompleteFunction callbackFunction);
 		static void Release(CoreClrNodejsFunc* function);
+		static void QueueRelease(CoreClrNodejsFunc* function);
+		static int GetLiveCount();
 };
 
 class CoreClrNodejsFuncInvokeContext
@@ -146,6 +299,8 @@ class CoreClrNodejsFuncInvokeContext
 	private:
 		uv_edge_async_t* uv_edge_async;
 
+		void CallFunction();
+
 	public:
 		void* Payload;
 		int PayloadType;
@@ -158,80 +313,10 @@ class CoreClrNodejsFuncInvokeContext
 
 		void Invoke();
 		static void InvokeCallback(void* data);
+		static void CompleteCallback(void* data, bool faulted, v8::Local<v8::Value> value);
 		void Complete(TaskStatus taskStatus, void* result, int resultType);
 };
 
-typedef struct v8ObjectData
-{
-	int propertiesCount;
-	int* propertyTypes;
-	char** propertyNames;
-	void** propertyData;
-
-	v8ObjectData()
-	{
-		propertiesCount = 0;
-		propertyTypes = NULL;
-		propertyNames = NULL;
-		propertyData = NULL;
-	}
-
-	~v8ObjectData()
-	{
-		for (int i = 0; i < propertiesCount; i++)
-		{
-			CoreClrFunc::FreeMarshalData(propertyData[i], propertyTypes[i]);
-			delete propertyNames[i];
-		}
-
-		delete propertyNames;
-		delete propertyData;
-		delete propertyTypes;
-	}
-} V8ObjectData;
-
-typedef struct v8ArrayData
-{
-	int arrayLength;
-	int* itemTypes;
-	void** itemValues;
-
-	v8ArrayData()
-	{
-		arrayLength = 0;
-		itemTypes = NULL;
-		itemValues = NULL;
-	}
-
-	~v8ArrayData()
-	{
-		for (int i = 0; i < arrayLength; i++)
-		{
-			CoreClrFunc::FreeMarshalData(itemValues[i], itemTypes[i]);
-		}
-
-		delete itemValues;
-		delete itemTypes;
-	}
-} V8ArrayData;
-
-typedef struct v8BufferData
-{
-	int bufferLength;
-	char* buffer;
-
-	v8BufferData()
-	{
-		bufferLength = 0;
-		buffer = NULL;
-	}
-
-	~v8BufferData()
-	{
-		delete buffer;
-	}
-} V8BufferData;
-
 typedef struct coreClrFuncWrap
 {
     CoreClrFunc* clrFunc;
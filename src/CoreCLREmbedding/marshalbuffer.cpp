@@ -0,0 +1,271 @@
+#include "edge.h"
+
+#define MARSHAL_WRITER_INITIAL_CAPACITY 64
+#define MARSHAL_BLOCK_MIN_SIZE 64
+#define MARSHAL_BLOCK_SIZE_CLASSES 7
+#define MARSHAL_BLOCK_MAX_POOLED 64
+
+// Header in front of every marshal block. Freed blocks of up to 4KB are kept in free lists per power of two
+// size class and reused by both the CLR and V8 side, larger blocks go straight back to the C runtime.
+typedef struct marshalBlockHeader
+{
+	size_t capacity;
+	struct marshalBlockHeader* next;
+} MarshalBlockHeader;
+
+static MarshalBlockHeader* freeBlocks[MARSHAL_BLOCK_SIZE_CLASSES];
+static int freeBlockCounts[MARSHAL_BLOCK_SIZE_CLASSES];
+static uv_mutex_t freeBlocksLock;
+static uv_once_t freeBlocksLockInitialized = UV_ONCE_INIT;
+
+static void InitializeFreeBlocksLock()
+{
+	uv_mutex_init(&freeBlocksLock);
+}
+
+static int GetSizeClass(size_t capacity)
+{
+	int sizeClass = 0;
+
+	for (size_t classCapacity = MARSHAL_BLOCK_MIN_SIZE; classCapacity < capacity; classCapacity <<= 1)
+	{
+		sizeClass++;
+	}
+
+	return sizeClass;
+}
+
+void* STDMETHODCALLTYPE AllocMarshalBlock(size_t size)
+{
+	int sizeClass = GetSizeClass(size);
+	MarshalBlockHeader* header = NULL;
+
+	if (sizeClass < MARSHAL_BLOCK_SIZE_CLASSES)
+	{
+		uv_once(&freeBlocksLockInitialized, InitializeFreeBlocksLock);
+		uv_mutex_lock(&freeBlocksLock);
+
+		header = freeBlocks[sizeClass];
+
+		if (header)
+		{
+			freeBlocks[sizeClass] = header->next;
+			freeBlockCounts[sizeClass]--;
+		}
+
+		uv_mutex_unlock(&freeBlocksLock);
+
+		size = (size_t)MARSHAL_BLOCK_MIN_SIZE << sizeClass;
+	}
+
+	if (!header)
+	{
+		header = (MarshalBlockHeader*)malloc(sizeof(MarshalBlockHeader) + size);
+		header->capacity = size;
+	}
+
+	return header + 1;
+}
+
+void* STDMETHODCALLTYPE ReallocMarshalBlock(void* block, size_t size)
+{
+	if (!block)
+	{
+		return AllocMarshalBlock(size);
+	}
+
+	size_t capacity = ((MarshalBlockHeader*)block - 1)->capacity;
+
+	if (size <= capacity)
+	{
+		return block;
+	}
+
+	void* resizedBlock = AllocMarshalBlock(size);
+
+	memcpy(resizedBlock, block, capacity);
+	FreeMarshalBlock(block);
+
+	return resizedBlock;
+}
+
+void STDMETHODCALLTYPE FreeMarshalBlock(void* block)
+{
+	if (!block)
+	{
+		return;
+	}
+
+	MarshalBlockHeader* header = (MarshalBlockHeader*)block - 1;
+	int sizeClass = GetSizeClass(header->capacity);
+
+	if (sizeClass < MARSHAL_BLOCK_SIZE_CLASSES)
+	{
+		uv_once(&freeBlocksLockInitialized, InitializeFreeBlocksLock);
+		uv_mutex_lock(&freeBlocksLock);
+
+		bool pooled = freeBlockCounts[sizeClass] < MARSHAL_BLOCK_MAX_POOLED;
+
+		if (pooled)
+		{
+			header->next = freeBlocks[sizeClass];
+			freeBlocks[sizeClass] = header;
+			freeBlockCounts[sizeClass]++;
+		}
+
+		uv_mutex_unlock(&freeBlocksLock);
+
+		if (pooled)
+		{
+			return;
+		}
+	}
+
+	free(header);
+}
+
+MarshalWriter::MarshalWriter() : data(NULL), length(0), capacity(0)
+{
+}
+
+MarshalWriter::~MarshalWriter()
+{
+	FreeMarshalBlock(data);
+}
+
+char* MarshalWriter::Detach()
+{
+	// Null values are passed without allocating any memory
+	char* result = length ? data : NULL;
+
+	if (!length)
+	{
+		FreeMarshalBlock(data);
+	}
+
+	data = NULL;
+	length = 0;
+	capacity = 0;
+
+	return result;
+}
+
+char* MarshalWriter::Reserve(size_t size)
+{
+	if (length + size > capacity)
+	{
+		while (length + size > capacity)
+		{
+			capacity = capacity ? capacity * 2 : MARSHAL_WRITER_INITIAL_CAPACITY;
+		}
+
+		data = (char*)ReallocMarshalBlock(data, capacity);
+	}
+
+	char* position = data + length;
+	length += size;
+
+	return position;
+}
+
+size_t MarshalWriter::ReserveInt32()
+{
+	size_t offset = length;
+	Reserve(sizeof(int32_t));
+
+	return offset;
+}
+
+void MarshalWriter::WriteInt32At(size_t offset, int32_t value)
+{
+	memcpy(data + offset, &value, sizeof(int32_t));
+}
+
+void MarshalWriter::WriteInt32(int32_t value)
+{
+	memcpy(Reserve(sizeof(int32_t)), &value, sizeof(int32_t));
+}
+
+void MarshalWriter::WriteDouble(double value)
+{
+	memcpy(Reserve(sizeof(double)), &value, sizeof(double));
+}
+
+void MarshalWriter::WritePointer(void* value)
+{
+	memcpy(Reserve(sizeof(void*)), &value, sizeof(void*));
+}
+
+void MarshalWriter::WriteString(v8::Local<v8::String> value)
+{
+	// Strings are copied once in V8's own representation, the CLR widens Latin-1 while building its string
+	int length = value->Length();
+
+	if (value->IsOneByte())
+	{
+		WriteInt32((length << 1) | 1);
+		value->WriteOneByte((uint8_t*)Reserve(length), 0, length, v8::String::NO_NULL_TERMINATION);
+	}
+	else
+	{
+		WriteInt32(length << 1);
+		value->Write((uint16_t*)Reserve(length * sizeof(uint16_t)), 0, length, v8::String::NO_NULL_TERMINATION);
+	}
+}
+
+MarshalReader::MarshalReader(const void* data) : position((const char*)data)
+{
+}
+
+int32_t MarshalReader::ReadInt32()
+{
+	int32_t value;
+
+	memcpy(&value, position, sizeof(int32_t));
+	position += sizeof(int32_t);
+
+	return value;
+}
+
+double MarshalReader::ReadDouble()
+{
+	double value;
+
+	memcpy(&value, position, sizeof(double));
+	position += sizeof(double);
+
+	return value;
+}
+
+void* MarshalReader::ReadPointer()
+{
+	void* value;
+
+	memcpy(&value, position, sizeof(void*));
+	position += sizeof(void*);
+
+	return value;
+}
+
+const char* MarshalReader::ReadBytes(size_t length)
+{
+	const char* value = position;
+	position += length;
+
+	return value;
+}
+
+v8::Local<v8::String> MarshalReader::ReadString(v8::NewStringType type)
+{
+	int32_t header = ReadInt32();
+	int32_t length = header >> 1;
+
+	if (header & 1)
+	{
+		return v8::String::NewFromOneByte(
+			v8::Isolate::GetCurrent(), (const uint8_t*)ReadBytes(length), type, length).ToLocalChecked();
+	}
+
+	return v8::String::NewFromTwoByte(
+		v8::Isolate::GetCurrent(), (const uint16_t*)ReadBytes(length * sizeof(uint16_t)), type, length).ToLocalChecked();
+}
@@ -2,6 +2,12 @@
 
 // The Callback to use to force the next tick to happen
 Nan::Callback* CallbackHelper::tickCallback;
+int CallbackHelper::batchDepth;
+bool CallbackHelper::tickPending;
+#ifdef EDGE_HAS_CALLBACK_SCOPE
+Nan::Persistent<v8::Object> CallbackHelper::resource;
+node::async_context CallbackHelper::asyncContext;
+#endif
 
 static void NoOpFunction(const Nan::FunctionCallbackInfo<v8::Value>& info)
 {
@@ -14,11 +20,61 @@ void CallbackHelper::Initialize()
     DBG("CallbackHelper::Initialize");
 
     tickCallback = new Nan::Callback(Nan::New<v8::Function>(NoOpFunction, Nan::Null()));
+    batchDepth = 0;
+    tickPending = false;
+
+#ifdef EDGE_HAS_CALLBACK_SCOPE
+    v8::Local<v8::Object> batchResource = Nan::New<v8::Object>();
+    resource.Reset(batchResource);
+    asyncContext = node::EmitAsyncInit(v8::Isolate::GetCurrent(), batchResource, "Edge.js");
+#endif
 }
 
 // Make the no-op callback, forcing the next tick to execute
 void CallbackHelper::KickNextTick()
 {
+    if (batchDepth > 0)
+    {
+        // The enclosing BatchScope runs the checkpoint when it is closed
+        tickPending = true;
+        return;
+    }
+
 	Nan::HandleScope scope;
 	tickCallback->Call(0, 0);
+}
+
+CallbackHelper::BatchScope::BatchScope()
+{
+#ifdef EDGE_HAS_CALLBACK_SCOPE
+    this->callbackScope = NULL;
+    if (batchDepth == 0)
+    {
+        // JavaScript invoked within the callback scope does not drain the tick queue on return,
+        // closing the scope does it once for the whole batch.
+        this->callbackScope = new node::CallbackScope(
+            v8::Isolate::GetCurrent(), Nan::New(resource), asyncContext);
+    }
+#endif
+
+    batchDepth++;
+}
+
+CallbackHelper::BatchScope::~BatchScope()
+{
+    if (--batchDepth > 0)
+    {
+        return;
+    }
+
+#ifdef EDGE_HAS_CALLBACK_SCOPE
+    tickPending = false;
+    delete this->callbackScope;
+#else
+    if (tickPending)
+    {
+        tickPending = false;
+        KickNextTick();
+    }
+#endif
 }
\ No newline at end of file
@@ -1,11 +1,12 @@
 using System;
 using System.Threading.Tasks;
 using System.Reflection;
+using System.Linq.Expressions;
 
 public class ClrFuncReflectionWrap
 {
-    Object instance;
-    MethodInfo invokeMethod;
+    Func<Object, Task<Object>> invokeFunc;
+    Type parameterType;
 
     public static ClrFuncReflectionWrap Create(Assembly assembly, String typeName, String methodName)
     {
@@ -16,20 +17,159 @@ public class ClrFuncReflectionWrap
             throw new TypeLoadException("Could not load type '" + typeName + "'");
         }
 
-        ClrFuncReflectionWrap wrap = new ClrFuncReflectionWrap();
-        wrap.instance = System.Activator.CreateInstance(startupType);
-        wrap.invokeMethod = startupType.GetMethod(methodName, BindingFlags.Instance | BindingFlags.Public);
-        if (wrap.invokeMethod == null)
+        MethodInfo invokeMethod = startupType.GetMethod(methodName, BindingFlags.Instance | BindingFlags.Static | BindingFlags.Public);
+        if (invokeMethod == null)
         {
             throw new System.InvalidOperationException(
-                "Unable to access the CLR method to wrap through reflection. Make sure it is a public instance method.");
+                "Unable to access the CLR method to wrap through reflection. Make sure it is a public instance or static method.");
         }
 
+        // Static methods are called without activating an instance of the type
+        Object instance = invokeMethod.IsStatic ? null : System.Activator.CreateInstance(startupType);
+        ParameterInfo[] parameters = invokeMethod.GetParameters();
+
+        ClrFuncReflectionWrap wrap = new ClrFuncReflectionWrap();
+        wrap.parameterType = parameters.Length > 0 ? parameters[0].ParameterType : typeof(Object);
+        wrap.invokeFunc = CreateInvokeFunc(instance, invokeMethod, parameters);
+
         return wrap;
     }
 
+    // Type of the first parameter of the wrapped method, payloads can be bound directly to it
+    public Type ParameterType
+    {
+        get { return this.parameterType; }
+    }
+
     public Task<Object> Call(Object payload)
     {
-        return (Task<Object>)this.invokeMethod.Invoke(this.instance, new object[] { payload });
+        return this.invokeFunc(payload);
+    }
+
+    // Methods with the exact Func<object, Task<object>> signature are bound as delegates, other signatures are
+    // compiled into a lambda that converts the payload and adapts the result to a Task<object>.
+    static Func<Object, Task<Object>> CreateInvokeFunc(Object instance, MethodInfo invokeMethod, ParameterInfo[] parameters)
+    {
+        if (parameters.Length == 1 && parameters[0].ParameterType == typeof(Object) && invokeMethod.ReturnType == typeof(Task<Object>))
+        {
+            return (Func<Object, Task<Object>>)invokeMethod.CreateDelegate(typeof(Func<Object, Task<Object>>), instance);
+        }
+
+        if (parameters.Length > 1)
+        {
+            throw new System.InvalidOperationException(
+                "The CLR method to wrap must accept a single parameter.");
+        }
+
+        ParameterExpression payload = Expression.Parameter(typeof(Object));
+        Expression[] arguments = parameters.Length == 0
+            ? new Expression[0]
+            : new Expression[] { ConvertPayload(payload, parameters[0].ParameterType) };
+        Expression call = Expression.Call(invokeMethod.IsStatic ? null : Expression.Constant(instance), invokeMethod, arguments);
+
+        return Expression.Lambda<Func<Object, Task<Object>>>(AdaptResult(call, invokeMethod.ReturnType), payload).Compile();
+    }
+
+    // Null payloads of value type parameters become default(T), as they did with MethodInfo.Invoke
+    static Expression ConvertPayload(ParameterExpression payload, Type parameterType)
+    {
+        Expression converted = Expression.Convert(payload, parameterType);
+
+        if (!parameterType.GetTypeInfo().IsValueType)
+        {
+            return converted;
+        }
+
+        return Expression.Condition(
+            Expression.Equal(payload, Expression.Constant(null)),
+            Expression.Default(parameterType),
+            converted);
+    }
+
+    static Expression AdaptResult(Expression call, Type returnType)
+    {
+        if (returnType == typeof(Task<Object>))
+        {
+            return call;
+        }
+
+        // ValueTask is matched by name, it is not part of every framework this file is compiled for
+        String returnTypeName = returnType.GetTypeInfo().IsGenericType
+            ? returnType.GetGenericTypeDefinition().FullName
+            : returnType.FullName;
+
+        if (returnTypeName == "System.Threading.Tasks.ValueTask`1" || returnTypeName == "System.Threading.Tasks.ValueTask")
+        {
+            call = Expression.Call(call, "AsTask", null);
+            returnType = call.Type;
+        }
+
+        if (typeof(Task).GetTypeInfo().IsAssignableFrom(returnType.GetTypeInfo()))
+        {
+            return returnType.GetTypeInfo().IsGenericType
+                ? Expression.Call(typeof(ClrFuncReflectionWrap), "FromTask", returnType.GenericTypeArguments, call)
+                : Expression.Call(typeof(ClrFuncReflectionWrap), "FromTask", null, call);
+        }
+
+        if (returnType == typeof(void))
+        {
+            return Expression.Block(call, Expression.Call(typeof(Task), "FromResult", new Type[] { typeof(Object) }, Expression.Constant(null)));
+        }
+
+        return Expression.Call(typeof(Task), "FromResult", new Type[] { typeof(Object) }, Expression.Convert(call, typeof(Object)));
+    }
+
+    static Task<Object> FromTask<T>(Task<T> task)
+    {
+        if (task.Status == TaskStatus.RanToCompletion)
+        {
+            return Task.FromResult((Object)task.Result);
+        }
+
+        TaskCompletionSource<Object> result = new TaskCompletionSource<Object>();
+        task.ContinueWith(t =>
+        {
+            if (t.IsFaulted)
+            {
+                result.SetException(t.Exception.InnerExceptions);
+            }
+            else if (t.IsCanceled)
+            {
+                result.SetCanceled();
+            }
+            else
+            {
+                result.SetResult(t.Result);
+            }
+        }, TaskContinuationOptions.ExecuteSynchronously);
+
+        return result.Task;
+    }
+
+    static Task<Object> FromTask(Task task)
+    {
+        if (task.Status == TaskStatus.RanToCompletion)
+        {
+            return Task.FromResult((Object)null);
+        }
+
+        TaskCompletionSource<Object> result = new TaskCompletionSource<Object>();
+        task.ContinueWith(t =>
+        {
+            if (t.IsFaulted)
+            {
+                result.SetException(t.Exception.InnerExceptions);
+            }
+            else if (t.IsCanceled)
+            {
+                result.SetCanceled();
+            }
+            else
+            {
+                result.SetResult(null);
+            }
+        }, TaskContinuationOptions.ExecuteSynchronously);
+
+        return result.Task;
     }
 };
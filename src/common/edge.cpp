@@ -18,6 +18,10 @@
 BOOL debugMode;
 BOOL enableScriptIgnoreAttribute;
 BOOL enableMarshalEnumAsInt;
+BOOL enableMarshalArrayAsTypedArray;
+BOOL enableMarshalPackedArrays;
+BOOL enablePinnedByteArrays;
+int minExternalStringLength;
 
 NAN_METHOD(initializeClrFunc)
 {
@@ -35,6 +39,27 @@ NAN_METHOD(initializeClrFunc)
 #endif
 }
 
+NAN_METHOD(getStats)
+{
+    // Number of JavaScript functions the CLR holds on to through proxies that have not been released yet,
+    // and number of CLR functions held by JavaScript proxies that have not been collected or disposed
+    int liveNodejsFuncs = 0;
+    int liveClrHandles = 0;
+#ifdef HAVE_CORECLR
+    liveNodejsFuncs += CoreClrNodejsFunc::GetLiveCount();
+    liveClrHandles += CoreClrFunc::GetLiveCount();
+#endif
+#if defined(HAVE_NATIVECLR) && !defined(EDGE_PLATFORM_WINDOWS)
+    liveNodejsFuncs += NodejsFunc::GetLiveCount();
+    liveClrHandles += ClrFunc::GetLiveCount();
+#endif
+
+    v8::Local<v8::Object> stats = Nan::New<v8::Object>();
+    Nan::Set(stats, Nan::New<v8::String>("liveNodejsFuncs").ToLocalChecked(), Nan::New<v8::Integer>(liveNodejsFuncs));
+    Nan::Set(stats, Nan::New<v8::String>("liveClrHandles").ToLocalChecked(), Nan::New<v8::Integer>(liveClrHandles));
+    info.GetReturnValue().Set(stats);
+}
+
 #ifdef EDGE_PLATFORM_WINDOWS
 #pragma unmanaged
 #endif
@@ -46,6 +71,14 @@ NAN_MODULE_INIT(init)
     V8SynchronizationContext::Initialize();
     CallbackHelper::Initialize();
 
+    // Settings are read once, before the runtime is initialized, CoreCLR receives them in its bootstrapper context
+    enableScriptIgnoreAttribute = HasEnvironmentVariable("EDGE_ENABLE_SCRIPTIGNOREATTRIBUTE");
+    enableMarshalEnumAsInt = HasEnvironmentVariable("EDGE_MARSHAL_ENUM_AS_INT");
+    enableMarshalArrayAsTypedArray = HasEnvironmentVariable("EDGE_MARSHAL_ARRAY_AS_TYPED_ARRAY");
+    enableMarshalPackedArrays = HasEnvironmentVariable("EDGE_MARSHAL_PACKED_ARRAYS");
+    enablePinnedByteArrays = HasEnvironmentVariable("EDGE_PIN_BYTE_ARRAYS");
+    minExternalStringLength = GetEnvironmentVariableInt("EDGE_EXTERNAL_STRING_MIN_LENGTH", EDGE_MIN_EXTERNAL_STRING_LENGTH);
+
 #ifdef HAVE_CORECLR
     if (FAILED(CoreClrEmbedding::Initialize(debugMode)))
 	{
@@ -58,11 +91,12 @@ NAN_MODULE_INIT(init)
 #endif
 #endif
 
-    enableScriptIgnoreAttribute = HasEnvironmentVariable("EDGE_ENABLE_SCRIPTIGNOREATTRIBUTE");
-    enableMarshalEnumAsInt = HasEnvironmentVariable("EDGE_MARSHAL_ENUM_AS_INT");
     Nan::Set(target,
         Nan::New<v8::String>("initializeClrFunc").ToLocalChecked(),
         Nan::New<v8::FunctionTemplate>(initializeClrFunc)->GetFunction());
+    Nan::Set(target,
+        Nan::New<v8::String>("getStats").ToLocalChecked(),
+        Nan::New<v8::FunctionTemplate>(getStats)->GetFunction());
 }
 
 #ifdef EDGE_PLATFORM_WINDOWS
@@ -77,6 +111,21 @@ bool HasEnvironmentVariable(const char* variableName)
 #endif
 }
 
+#ifdef EDGE_PLATFORM_WINDOWS
+#pragma unmanaged
+#endif
+int GetEnvironmentVariableInt(const char* variableName, int defaultValue)
+{
+#ifdef EDGE_PLATFORM_WINDOWS
+    char value[32];
+    DWORD length = GetEnvironmentVariable(variableName, value, sizeof(value));
+    return (length > 0 && length < sizeof(value)) ? atoi(value) : defaultValue;
+#else
+    const char* value = getenv(variableName);
+    return value ? atoi(value) : defaultValue;
+#endif
+}
+
 #ifdef EDGE_PLATFORM_WINDOWS
 #pragma unmanaged
 #endif
@@ -61,16 +61,25 @@ typedef int BOOL;
 extern BOOL debugMode;
 extern BOOL enableScriptIgnoreAttribute;
 extern BOOL enableMarshalEnumAsInt;
+extern BOOL enableMarshalArrayAsTypedArray;
+extern BOOL enableMarshalPackedArrays;
+extern BOOL enablePinnedByteArrays;
+extern int minExternalStringLength;
 
 #define DBG(...) if (debugMode) { printf(__VA_ARGS__); printf("\n"); }
 
+// node::CallbackScope is available starting with Node.js 9
+#if NODE_MAJOR_VERSION >= 9
+#define EDGE_HAS_CALLBACK_SCOPE 1
+#endif
+
 typedef void (*uv_async_edge_cb)(void* data);
 
 typedef struct uv_edge_async_s {
-    uv_async_t uv_async;
     uv_async_edge_cb action;
     void* data;
-    bool singleton;
+    bool keepAlive;
+    struct uv_edge_async_s* next;
 } uv_edge_async_t;
 
 class V8SynchronizationContext {
@@ -78,6 +87,7 @@ private:
 
     static unsigned long v8ThreadId;
     static unsigned long GetCurrentThreadId();
+    static int keepAliveCount;
 
 public:
 
@@ -91,24 +101,83 @@ public:
     // It also means that existence of .NET proxies to JavaScript functions in the CLR does not prevent the
     // process from exiting.
     // In this model, JavaScript owns the lifetime of the process.
+    // All actions are dispatched through a single uv_async_t. ExecuteAction pushes the action onto a
+    // lock-free queue which is drained in its entirety on the next wakeup. The uv_async_t is ref'd only
+    // while actions registered on V8 thread are outstanding.
 
-    static uv_edge_async_t* uv_edge_async;
-    static uv_sem_t* funcWaitHandle;
+    static uv_async_t* uv_async;
 
     static void Initialize();
+    static bool IsOnV8Thread();
     static uv_edge_async_t* RegisterAction(uv_async_edge_cb action, void* data);
     static void ExecuteAction(uv_edge_async_t* uv_edge_async);
     static void CancelAction(uv_edge_async_t* uv_edge_async);
-    static void Unref(uv_edge_async_t* uv_edge_async);
 };
 
 class CallbackHelper {
 private:
     static Nan::Callback* tickCallback;
+    static int batchDepth;
+    static bool tickPending;
+#ifdef EDGE_HAS_CALLBACK_SCOPE
+    static Nan::Persistent<v8::Object> resource;
+    static node::async_context asyncContext;
+#endif
 
 public:
     static void Initialize();
     static void KickNextTick();
+
+    // While a BatchScope is open, KickNextTick does not call into JavaScript. A single
+    // nextTick/microtask checkpoint runs instead when the outermost BatchScope is closed.
+    class BatchScope {
+    private:
+#ifdef EDGE_HAS_CALLBACK_SCOPE
+        node::CallbackScope* callbackScope;
+#endif
+
+    public:
+        BatchScope();
+        ~BatchScope();
+    };
+};
+
+typedef void (*NodejsFuncCompleteCallback)(void* context, bool faulted, v8::Local<v8::Value> value);
+
+// Calls a JavaScript function on behalf of .NET and reports its outcome. The function receives an
+// (error, result) callback; functions declaring fewer than two parameters may instead return the result
+// or a Promise of it. Completions and their Promise reactions are pooled on V8 thread and never freed,
+// since JavaScript may keep functions pointing at them. Each call stamps its completion with a new
+// generation, a callback called again after its call completed finds a different generation and is ignored.
+class NodejsFuncCompletion {
+private:
+    static NodejsFuncCompletion* pool;
+    static Nan::Persistent<v8::String> lengthName;
+    static Nan::Persistent<v8::Function> callbackConstructor;
+
+    uint32_t index;
+    uint32_t generation;
+    void* context;
+    NodejsFuncCompleteCallback complete;
+    bool invoking;
+    bool awaitingPromise;
+    Nan::Persistent<v8::Function> onFulfilled;
+    Nan::Persistent<v8::Function> onRejected;
+    NodejsFuncCompletion* next;
+
+    NodejsFuncCompletion();
+
+    static NodejsFuncCompletion* Acquire(void* context, NodejsFuncCompleteCallback complete);
+    void ReleaseIfIdle();
+    void Complete(bool faulted, v8::Local<v8::Value> value);
+    v8::Local<v8::Object> NewCallback();
+
+    static void Callback(const v8::FunctionCallbackInfo<v8::Value>& info);
+    static NAN_METHOD(Fulfilled);
+    static NAN_METHOD(Rejected);
+
+public:
+    static void Invoke(v8::Local<v8::Function> func, v8::Local<v8::Value> payload, void* context, NodejsFuncCompleteCallback complete);
 };
 
 typedef enum taskStatus
@@ -123,9 +192,57 @@ typedef enum taskStatus
     TaskStatusFaulted = 7
 } TaskStatus;
 
+// Controls how node.js Buffers passed to a CLR function are marshaled
+typedef enum bufferMarshalMode
+{
+    BufferMarshalModeCopy = 0,      // the CLR receives a byte[] copy of the Buffer
+    BufferMarshalModeView = 1,      // the CLR receives a Stream over the Buffer's memory, valid until the call completes
+    BufferMarshalModeTransfer = 2   // the CLR receives a Stream that owns the Buffer's memory, the Buffer is detached
+} BufferMarshalMode;
+
+typedef void (__cdecl *ReleaseBufferFunction)(void* context);
+
+// With EDGE_PIN_BYTE_ARRAYS set, CLR byte arrays at least this long are passed to node.js as external Buffers
+// over pinned CLR memory. Smaller arrays live in the compacting small object heap and are always copied.
+#define EDGE_MIN_PINNED_BUFFER_LENGTH 85000
+
+// CLR strings at least EDGE_EXTERNAL_STRING_MIN_LENGTH characters long are passed to node.js as external strings
+// over pinned CLR memory. External strings are off (0) unless that variable is set.
+#define EDGE_MIN_EXTERNAL_STRING_LENGTH 0
+
+// Number of distinct property names of JavaScript objects whose CLR strings are cached
+#define EDGE_MAX_CACHED_PROPERTY_NAMES 1024
+#define EDGE_MAX_POOLED_INVOKE_CONTEXTS 256
+
+// Element types of TypedArrays marshaled to and from primitive CLR arrays
+typedef enum typedArrayType
+{
+    TypedArrayTypeNone = 0,
+    TypedArrayTypeInt8 = 1,         // sbyte[]
+    TypedArrayTypeUint8 = 2,        // byte[]
+    TypedArrayTypeUint8Clamped = 3, // byte[]
+    TypedArrayTypeInt16 = 4,        // short[]
+    TypedArrayTypeUint16 = 5,       // ushort[]
+    TypedArrayTypeInt32 = 6,        // int[]
+    TypedArrayTypeUint32 = 7,       // uint[]
+    TypedArrayTypeFloat32 = 8,      // float[]
+    TypedArrayTypeFloat64 = 9       // double[]
+} TypedArrayType;
+
+BufferMarshalMode GetBufferMarshalMode(v8::Local<v8::Object> options);
+char* DetachBufferData(v8::Local<v8::Object> buffer, void** releaseContext);
+void __cdecl FreeDetachedBufferData(void* releaseContext);
+v8::Local<v8::Object> NewExternalBuffer(char* data, size_t length, ReleaseBufferFunction release, void* releaseContext);
+v8::Local<v8::String> NewExternalString(const uint16_t* data, size_t length, ReleaseBufferFunction release, void* releaseContext);
+bool IsRepeatedPropertyName(int hash);
+TypedArrayType GetTypedArrayType(v8::Local<v8::Value> value);
+size_t GetTypedArrayElementSize(TypedArrayType type);
+v8::Local<v8::Object> NewTypedArray(TypedArrayType type, const void* data, size_t length);
+
 v8::Local<Value> throwV8Exception(v8::Local<Value> exception);
 v8::Local<Value> throwV8Exception(const char* format, ...);
 
 bool HasEnvironmentVariable(const char* variableName);
+int GetEnvironmentVariableInt(const char* variableName, int defaultValue);
 
 #endif
@@ -0,0 +1,69 @@
+using System;
+using System.IO;
+using System.Runtime.InteropServices;
+
+// Stream over native memory of a node.js Buffer passed to the CLR without copying. Buffers passed
+// by functions created with zeroCopyBuffers are only valid until the call that received them completes.
+// Buffers passed by functions created with transferBuffers are owned by the stream and released when
+// the stream is disposed or finalized.
+public class NativeBufferStream : UnmanagedMemoryStream
+{
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    delegate void ReleaseBufferFunction(IntPtr context);
+
+    class NativeBuffer : SafeBuffer
+    {
+        IntPtr release;
+        IntPtr releaseContext;
+
+        public NativeBuffer(IntPtr buffer, int length, IntPtr release, IntPtr releaseContext)
+            : base(true)
+        {
+            this.release = release;
+            this.releaseContext = releaseContext;
+            this.SetHandle(buffer);
+            this.Initialize((ulong)length);
+        }
+
+        // Empty Buffers may not have any memory behind them, the release function must still run
+        public override bool IsInvalid
+        {
+            get { return false; }
+        }
+
+        protected override bool ReleaseHandle()
+        {
+            if (this.release != IntPtr.Zero)
+            {
+                ReleaseBufferFunction releaseFunction = (ReleaseBufferFunction)Marshal.GetDelegateForFunctionPointer(
+                    this.release, typeof(ReleaseBufferFunction));
+                releaseFunction(this.releaseContext);
+            }
+
+            return true;
+        }
+    }
+
+    NativeBuffer nativeBuffer;
+
+    public NativeBufferStream(IntPtr buffer, int length, IntPtr release, IntPtr releaseContext)
+        : this(new NativeBuffer(buffer, length, release, releaseContext), length)
+    {
+    }
+
+    NativeBufferStream(NativeBuffer nativeBuffer, int length)
+        : base(nativeBuffer, 0, length, FileAccess.ReadWrite)
+    {
+        this.nativeBuffer = nativeBuffer;
+    }
+
+    protected override void Dispose(bool disposing)
+    {
+        base.Dispose(disposing);
+
+        if (disposing)
+        {
+            this.nativeBuffer.Dispose();
+        }
+    }
+}
@@ -0,0 +1,230 @@
+#include "edge_common.h"
+#include <vector>
+
+NodejsFuncCompletion* NodejsFuncCompletion::pool;
+Nan::Persistent<v8::String> NodejsFuncCompletion::lengthName;
+Nan::Persistent<v8::Function> NodejsFuncCompletion::callbackConstructor;
+
+// Every completion ever created, callbacks find theirs by index
+static std::vector<NodejsFuncCompletion*> completions;
+
+// A callback identifies the call it was created for by the index and generation of its completion, kept in
+// two internal fields. Generations are compared modulo 2^30 so that both always fit into a small integer.
+#define COMPLETION_GENERATION_MASK 0x3FFFFFFF
+
+NodejsFuncCompletion::NodejsFuncCompletion()
+    : index((uint32_t)completions.size()), generation(0), context(NULL), complete(NULL),
+      invoking(false), awaitingPromise(false), next(NULL)
+{
+    v8::Local<v8::External> data = Nan::New<v8::External>((void*)this);
+
+    this->onFulfilled.Reset(Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Fulfilled, data)).ToLocalChecked());
+    this->onRejected.Reset(Nan::GetFunction(Nan::New<v8::FunctionTemplate>(Rejected, data)).ToLocalChecked());
+
+    completions.push_back(this);
+}
+
+NodejsFuncCompletion* NodejsFuncCompletion::Acquire(void* context, NodejsFuncCompleteCallback complete)
+{
+    NodejsFuncCompletion* completion = pool;
+
+    if (completion)
+    {
+        pool = completion->next;
+    }
+    else
+    {
+        completion = new NodejsFuncCompletion();
+    }
+
+    completion->generation++;
+    completion->context = context;
+    completion->complete = complete;
+    completion->next = NULL;
+
+    return completion;
+}
+
+void NodejsFuncCompletion::ReleaseIfIdle()
+{
+    // Completions stay out of the pool while their function runs or their Promise reactions are pending.
+    // Callbacks called after this belong to an earlier generation and are ignored.
+    if (this->context || this->invoking || this->awaitingPromise)
+    {
+        return;
+    }
+
+    this->complete = NULL;
+    this->next = pool;
+    pool = this;
+}
+
+void NodejsFuncCompletion::Complete(bool faulted, v8::Local<v8::Value> value)
+{
+    DBG("NodejsFuncCompletion::Complete");
+
+    // Only the first outcome of a call is reported
+    if (this->context)
+    {
+        void* context = this->context;
+        this->context = NULL;
+        this->complete(context, faulted, value);
+    }
+
+    this->ReleaseIfIdle();
+}
+
+v8::Local<v8::Object> NodejsFuncCompletion::NewCallback()
+{
+    if (callbackConstructor.IsEmpty())
+    {
+        // Callbacks are callable instances of one template, so creating one does not instantiate a new function
+        v8::Local<v8::FunctionTemplate> callbackTemplate = Nan::New<v8::FunctionTemplate>();
+        v8::Local<v8::ObjectTemplate> instanceTemplate = callbackTemplate->InstanceTemplate();
+
+        instanceTemplate->SetInternalFieldCount(2);
+        instanceTemplate->SetCallAsFunctionHandler(Callback);
+
+        v8::Local<v8::Function> constructor = Nan::GetFunction(callbackTemplate).ToLocalChecked();
+        v8::Local<v8::Object> prototype = Nan::Get(constructor, Nan::New<v8::String>("prototype").ToLocalChecked())
+            .ToLocalChecked().As<v8::Object>();
+
+        // Callbacks inherit call, apply and bind from Function.prototype like any other function
+        Nan::SetPrototype(prototype, constructor->GetPrototype());
+        callbackConstructor.Reset(constructor);
+    }
+
+    // JavaScript may hold on to a callback for as long as it likes, so callbacks are never shared between calls.
+    // The callback object is all that is allocated per call.
+    v8::Local<v8::Object> callback = Nan::NewInstance(Nan::New(callbackConstructor)).ToLocalChecked();
+
+    callback->SetInternalField(0, Nan::New<v8::Integer>(this->index));
+    callback->SetInternalField(1, Nan::New<v8::Integer>(this->generation & COMPLETION_GENERATION_MASK));
+
+    return callback;
+}
+
+void NodejsFuncCompletion::Callback(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    DBG("NodejsFuncCompletion::Callback");
+
+    Nan::HandleScope scope;
+    v8::Local<v8::Object> callback = info.Holder();
+    uint32_t index = Nan::To<uint32_t>(callback->GetInternalField(0).As<v8::Value>()).FromJust();
+    uint32_t generation = Nan::To<uint32_t>(callback->GetInternalField(1).As<v8::Value>()).FromJust();
+    NodejsFuncCompletion* completion = completions[index];
+
+    if ((completion->generation & COMPLETION_GENERATION_MASK) == generation && completion->context)
+    {
+        if (!info[0]->IsUndefined() && !info[0]->IsNull())
+        {
+            completion->Complete(true, info[0]);
+        }
+        else
+        {
+            completion->Complete(false, info[1]);
+        }
+    }
+    else
+    {
+        DBG("NodejsFuncCompletion::Callback - Ignoring callback of a completed call");
+    }
+
+    info.GetReturnValue().SetUndefined();
+}
+
+NAN_METHOD(NodejsFuncCompletion::Fulfilled)
+{
+    DBG("NodejsFuncCompletion::Fulfilled");
+
+    Nan::HandleScope scope;
+    NodejsFuncCompletion* completion = (NodejsFuncCompletion*)info.Data().As<v8::External>()->Value();
+
+    // Reactions are only reachable by the Promise they were attached to, and exactly one of them runs
+    if (completion->awaitingPromise)
+    {
+        completion->awaitingPromise = false;
+        completion->Complete(false, info[0]);
+    }
+}
+
+NAN_METHOD(NodejsFuncCompletion::Rejected)
+{
+    DBG("NodejsFuncCompletion::Rejected");
+
+    Nan::HandleScope scope;
+    NodejsFuncCompletion* completion = (NodejsFuncCompletion*)info.Data().As<v8::External>()->Value();
+
+    if (completion->awaitingPromise)
+    {
+        completion->awaitingPromise = false;
+        completion->Complete(true, info[0]);
+    }
+}
+
+void NodejsFuncCompletion::Invoke(v8::Local<v8::Function> func, v8::Local<v8::Value> payload, void* context, NodejsFuncCompleteCallback complete)
+{
+    DBG("NodejsFuncCompletion::Invoke");
+
+    Nan::HandleScope scope;
+    NodejsFuncCompletion* completion = Acquire(context, complete);
+    v8::Local<v8::Value> argv[] = { payload, completion->NewCallback() };
+    v8::Local<v8::Value> result;
+    Nan::TryCatch tryCatch;
+
+    // The completion must not be pooled while the function runs, even if it calls back synchronously
+    completion->invoking = true;
+
+    DBG("NodejsFuncCompletion::Invoke - Calling JavaScript function");
+    bool called = Nan::Call(func, Nan::GetCurrentContext()->Global(), 2, argv).ToLocal(&result);
+    DBG("NodejsFuncCompletion::Invoke - Called JavaScript function");
+
+    completion->invoking = false;
+
+    if (!called || tryCatch.HasCaught())
+    {
+        DBG("NodejsFuncCompletion::Invoke - Caught JavaScript exception");
+        completion->Complete(true, tryCatch.Exception());
+        return;
+    }
+
+    if (completion->context && !result->IsUndefined())
+    {
+        if (lengthName.IsEmpty())
+        {
+            lengthName.Reset(Nan::New<v8::String>("length").ToLocalChecked());
+        }
+
+        // Functions that take a callback may return anything, only the result of those that do not is used
+        v8::Local<v8::Value> length;
+
+        if (Nan::Get(func, Nan::New(lengthName)).ToLocal(&length) && length->IsNumber() && length.As<v8::Number>()->Value() < 2)
+        {
+            if (result->IsPromise())
+            {
+                v8::Local<v8::Context> v8Context = Nan::GetCurrentContext();
+                v8::MaybeLocal<v8::Promise> reaction = result.As<v8::Promise>()->Then(v8Context, Nan::New(completion->onFulfilled));
+
+                completion->awaitingPromise = !reaction.IsEmpty();
+
+                if (completion->awaitingPromise)
+                {
+                    // Rejections pass through the derived promise, so it does not end up unhandled
+                    reaction = reaction.ToLocalChecked()->Catch(v8Context, Nan::New(completion->onRejected));
+                }
+
+                if (reaction.IsEmpty())
+                {
+                    completion->Complete(true, tryCatch.Exception());
+                    return;
+                }
+            }
+            else
+            {
+                completion->Complete(false, result);
+            }
+        }
+    }
+
+    completion->ReleaseIfIdle();
+}
@@ -1,4 +1,5 @@
 #include "edge_common.h"
+#include <unordered_set>
 
 v8::Local<Value> throwV8Exception(v8::Local<Value> exception)
 {
@@ -27,3 +28,275 @@ v8::Local<Value> throwV8Exception(const char* format, ...)
 
 	return scope.Escape(exception);
 }
+
+BufferMarshalMode GetBufferMarshalMode(v8::Local<v8::Object> options)
+{
+	if (options->Get(Nan::New<v8::String>("transferBuffers").ToLocalChecked())->IsTrue())
+	{
+		return BufferMarshalModeTransfer;
+	}
+
+	if (options->Get(Nan::New<v8::String>("zeroCopyBuffers").ToLocalChecked())->IsTrue())
+	{
+		return BufferMarshalModeView;
+	}
+
+	return BufferMarshalModeCopy;
+}
+
+// Memory a Buffer hands over to the CLR. Memory taken from an ArrayBuffer belongs to the isolate's allocator
+// and must go back to it on V8 thread, a copy of a Buffer that could not be detached is malloc'd.
+typedef struct detachedBufferData
+{
+	char* copy;
+#if NODE_MAJOR_VERSION >= 14
+	std::shared_ptr<v8::BackingStore> backingStore;
+#else
+	void* data;
+	size_t length;
+#endif
+} DetachedBufferData;
+
+char* DetachBufferData(v8::Local<v8::Object> buffer, void** releaseContext)
+{
+	size_t length = node::Buffer::Length(buffer);
+	v8::Local<v8::Uint8Array> view = buffer.As<v8::Uint8Array>();
+	v8::Local<v8::ArrayBuffer> arrayBuffer = view->Buffer();
+
+	DetachedBufferData* detached = new DetachedBufferData();
+	*releaseContext = detached;
+
+	// Small Buffers are slices of a shared pool, only a Buffer spanning the entire memory of its ArrayBuffer
+	// can give that memory away. Before Node.js 14 the memory of external ArrayBuffers is owned by someone else.
+#if NODE_MAJOR_VERSION >= 12
+	bool detachable = arrayBuffer->IsDetachable();
+#else
+	bool detachable = arrayBuffer->IsNeuterable();
+#endif
+#if NODE_MAJOR_VERSION < 14
+	detachable = detachable && !arrayBuffer->IsExternal();
+#endif
+	if (length > 0 && view->ByteOffset() == 0 && arrayBuffer->ByteLength() == length && detachable)
+	{
+#if NODE_MAJOR_VERSION >= 14
+		// The backing store outlives the ArrayBuffer for as long as the CLR holds a reference to it
+		detached->backingStore = arrayBuffer->GetBackingStore();
+		arrayBuffer->Detach();
+		char* data = (char*)detached->backingStore->Data();
+#else
+		v8::ArrayBuffer::Contents contents = arrayBuffer->Externalize();
+#if NODE_MAJOR_VERSION >= 12
+		arrayBuffer->Detach();
+#else
+		arrayBuffer->Neuter();
+#endif
+		detached->data = contents.Data();
+		detached->length = contents.ByteLength();
+		char* data = (char*)contents.Data();
+#endif
+		DBG("DetachBufferData - Took ownership of %d bytes", (int)length);
+
+		return data;
+	}
+
+	detached->copy = (char*)malloc(length > 0 ? length : 1);
+	memcpy(detached->copy, node::Buffer::Data(buffer), length);
+
+	return detached->copy;
+}
+
+static void ReleaseDetachedBufferData(void* data)
+{
+	// This executes on V8 thread
+
+	DBG("ReleaseDetachedBufferData");
+
+	DetachedBufferData* detached = (DetachedBufferData*)data;
+#if NODE_MAJOR_VERSION >= 14
+	detached->backingStore.reset();
+#elif NODE_MAJOR_VERSION >= 12
+	v8::Isolate::GetCurrent()->GetArrayBufferAllocator()->Free(detached->data, detached->length);
+#else
+	// Isolates do not expose their allocator before Node.js 12, the allocator of earlier versions is malloc based
+	free(detached->data);
+#endif
+	delete detached;
+}
+
+void __cdecl FreeDetachedBufferData(void* releaseContext)
+{
+	// This executes on whichever thread the CLR releases the data on
+
+	DetachedBufferData* detached = (DetachedBufferData*)releaseContext;
+
+	if (detached->copy)
+	{
+		free(detached->copy);
+		delete detached;
+		return;
+	}
+
+	V8SynchronizationContext::ExecuteAction(V8SynchronizationContext::RegisterAction(ReleaseDetachedBufferData, detached));
+}
+
+typedef struct externalBufferData
+{
+	ReleaseBufferFunction release;
+	void* releaseContext;
+} ExternalBufferData;
+
+static void ReleaseExternalBuffer(char* data, void* hint)
+{
+	DBG("ReleaseExternalBuffer");
+
+	ExternalBufferData* bufferData = (ExternalBufferData*)hint;
+	bufferData->release(bufferData->releaseContext);
+	delete bufferData;
+}
+
+v8::Local<v8::Object> NewExternalBuffer(char* data, size_t length, ReleaseBufferFunction release, void* releaseContext)
+{
+	Nan::EscapableHandleScope scope;
+
+	ExternalBufferData* bufferData = new ExternalBufferData;
+	bufferData->release = release;
+	bufferData->releaseContext = releaseContext;
+
+	return scope.Escape(Nan::NewBuffer(data, length, ReleaseExternalBuffer, bufferData).ToLocalChecked());
+}
+
+class ExternalClrString : public v8::String::ExternalStringResource
+{
+	const uint16_t* chars;
+	size_t charCount;
+	ReleaseBufferFunction release;
+	void* releaseContext;
+
+public:
+	ExternalClrString(const uint16_t* chars, size_t charCount, ReleaseBufferFunction release, void* releaseContext)
+		: chars(chars), charCount(charCount), release(release), releaseContext(releaseContext)
+	{
+	}
+
+	~ExternalClrString()
+	{
+		DBG("ExternalClrString::~ExternalClrString");
+		release(releaseContext);
+	}
+
+	const uint16_t* data() const
+	{
+		return chars;
+	}
+
+	size_t length() const
+	{
+		return charCount;
+	}
+};
+
+v8::Local<v8::String> NewExternalString(const uint16_t* data, size_t length, ReleaseBufferFunction release, void* releaseContext)
+{
+	Nan::EscapableHandleScope scope;
+
+	// V8 disposes of the resource, and with it releases the CLR string, when the string is collected
+	return scope.Escape(Nan::New<v8::String>(new ExternalClrString(data, length, release, releaseContext)).ToLocalChecked());
+}
+
+bool IsRepeatedPropertyName(int hash)
+{
+	// Hashes of property names seen once. Names are cached the second time they are seen, so keys
+	// of one-off, dictionary-like payloads do not use up the property name cache.
+	static std::unordered_set<int> seenNames;
+
+	if (seenNames.erase(hash))
+	{
+		return true;
+	}
+
+	if (seenNames.size() >= EDGE_MAX_CACHED_PROPERTY_NAMES)
+	{
+		seenNames.clear();
+	}
+
+	seenNames.insert(hash);
+
+	return false;
+}
+
+TypedArrayType GetTypedArrayType(v8::Local<v8::Value> value)
+{
+	if (!value->IsTypedArray())
+	{
+		return TypedArrayTypeNone;
+	}
+
+	if (value->IsFloat64Array()) return TypedArrayTypeFloat64;
+	if (value->IsFloat32Array()) return TypedArrayTypeFloat32;
+	if (value->IsInt32Array()) return TypedArrayTypeInt32;
+	if (value->IsUint32Array()) return TypedArrayTypeUint32;
+	if (value->IsInt16Array()) return TypedArrayTypeInt16;
+	if (value->IsUint16Array()) return TypedArrayTypeUint16;
+	if (value->IsInt8Array()) return TypedArrayTypeInt8;
+	if (value->IsUint8Array()) return TypedArrayTypeUint8;
+	if (value->IsUint8ClampedArray()) return TypedArrayTypeUint8Clamped;
+
+	// BigInt arrays have no counterpart and are marshaled as plain objects
+	return TypedArrayTypeNone;
+}
+
+size_t GetTypedArrayElementSize(TypedArrayType type)
+{
+	switch (type)
+	{
+		case TypedArrayTypeInt8:
+		case TypedArrayTypeUint8:
+		case TypedArrayTypeUint8Clamped:
+			return 1;
+		case TypedArrayTypeInt16:
+		case TypedArrayTypeUint16:
+			return 2;
+		case TypedArrayTypeInt32:
+		case TypedArrayTypeUint32:
+		case TypedArrayTypeFloat32:
+			return 4;
+		case TypedArrayTypeFloat64:
+			return 8;
+		default:
+			return 0;
+	}
+}
+
+v8::Local<v8::Object> NewTypedArray(TypedArrayType type, const void* data, size_t length)
+{
+	Nan::EscapableHandleScope scope;
+
+	size_t byteLength = length * GetTypedArrayElementSize(type);
+	v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), byteLength);
+
+	if (byteLength > 0)
+	{
+#if NODE_MAJOR_VERSION >= 14
+		memcpy(buffer->GetBackingStore()->Data(), data, byteLength);
+#else
+		memcpy(buffer->GetContents().Data(), data, byteLength);
+#endif
+	}
+
+	v8::Local<v8::Object> result;
+
+	switch (type)
+	{
+		case TypedArrayTypeInt8: result = v8::Int8Array::New(buffer, 0, length); break;
+		case TypedArrayTypeUint8: result = v8::Uint8Array::New(buffer, 0, length); break;
+		case TypedArrayTypeUint8Clamped: result = v8::Uint8ClampedArray::New(buffer, 0, length); break;
+		case TypedArrayTypeInt16: result = v8::Int16Array::New(buffer, 0, length); break;
+		case TypedArrayTypeUint16: result = v8::Uint16Array::New(buffer, 0, length); break;
+		case TypedArrayTypeInt32: result = v8::Int32Array::New(buffer, 0, length); break;
+		case TypedArrayTypeUint32: result = v8::Uint32Array::New(buffer, 0, length); break;
+		case TypedArrayTypeFloat32: result = v8::Float32Array::New(buffer, 0, length); break;
+		default: result = v8::Float64Array::New(buffer, 0, length); break;
+	}
+
+	return scope.Escape(result);
+}
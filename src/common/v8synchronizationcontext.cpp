@@ -16,101 +16,146 @@
  */
 #include "edge_common.h"
 
+// Head of the lock-free stack of actions waiting to run on V8 thread. Any thread may push onto it
+// in ExecuteAction, the V8 thread takes the whole stack at once in continueOnV8Thread.
+static uv_edge_async_t* volatile pendingActions = NULL;
+
+static bool pushPendingAction(uv_edge_async_t* uv_edge_async)
+{
+    uv_edge_async_t* head = pendingActions;
+    uv_edge_async->next = head;
+#ifdef _WIN32
+    return InterlockedCompareExchangePointer((PVOID volatile*)&pendingActions, uv_edge_async, head) == head;
+#else
+    return __atomic_compare_exchange_n(&pendingActions, &head, uv_edge_async, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+#endif
+}
+
+static uv_edge_async_t* takePendingActions()
+{
+#ifdef _WIN32
+    return (uv_edge_async_t*)InterlockedExchangePointer((PVOID volatile*)&pendingActions, NULL);
+#else
+    return __atomic_exchange_n(&pendingActions, (uv_edge_async_t*)NULL, __ATOMIC_ACQUIRE);
+#endif
+}
+
 void continueOnV8Thread(uv_async_t* handle, int status)
 {
     // This executes on V8 thread
 
     DBG("continueOnV8Thread");
-    Nan::HandleScope scope;
-    uv_edge_async_t* uv_edge_async = (uv_edge_async_t*)handle;
-    uv_async_edge_cb action = uv_edge_async->action;
-    void* data = uv_edge_async->data;
-    V8SynchronizationContext::CancelAction(uv_edge_async);
-    action(data);
+
+    // Drain all actions queued since the last wakeup. Producers push onto the head
+    // of the stack, so reverse it to run the actions in the order they were queued.
+    uv_edge_async_t* pending = takePendingActions();
+    uv_edge_async_t* ordered = NULL;
+    while (pending)
+    {
+        uv_edge_async_t* next = pending->next;
+        pending->next = ordered;
+        ordered = pending;
+        pending = next;
+    }
+
+    if (!ordered)
+    {
+        return;
+    }
+
+    Nan::HandleScope batchHandleScope;
+    CallbackHelper::BatchScope batchScope;
+    while (ordered)
+    {
+        Nan::HandleScope scope;
+        uv_edge_async_t* current = ordered;
+        ordered = current->next;
+        uv_async_edge_cb action = current->action;
+        void* data = current->data;
+        V8SynchronizationContext::CancelAction(current);
+        action(data);
+    }
 }
 
 unsigned long V8SynchronizationContext::v8ThreadId;
-uv_sem_t* V8SynchronizationContext::funcWaitHandle;
-uv_edge_async_t* V8SynchronizationContext::uv_edge_async;
+int V8SynchronizationContext::keepAliveCount;
+uv_async_t* V8SynchronizationContext::uv_async;
 
 void V8SynchronizationContext::Initialize()
 {
     // This executes on V8 thread
 
     DBG("V8SynchronizationContext::Initialize");
-    V8SynchronizationContext::uv_edge_async = new uv_edge_async_t;
-    uv_edge_async->singleton = TRUE;
-    uv_async_init(uv_default_loop(), &V8SynchronizationContext::uv_edge_async->uv_async, (uv_async_cb)continueOnV8Thread);
-    V8SynchronizationContext::Unref(V8SynchronizationContext::uv_edge_async);
-    V8SynchronizationContext::funcWaitHandle = new uv_sem_t;
-    uv_sem_init(V8SynchronizationContext::funcWaitHandle, 1);
+    V8SynchronizationContext::uv_async = new uv_async_t;
+    uv_async_init(uv_default_loop(), V8SynchronizationContext::uv_async, (uv_async_cb)continueOnV8Thread);
+    uv_unref((uv_handle_t*)V8SynchronizationContext::uv_async);
+    V8SynchronizationContext::keepAliveCount = 0;
     V8SynchronizationContext::v8ThreadId = V8SynchronizationContext::GetCurrentThreadId();
 }
 
-void V8SynchronizationContext::Unref(uv_edge_async_t* uv_edge_async)
+bool V8SynchronizationContext::IsOnV8Thread()
 {
-    DBG("V8SynchronizationContext::Unref");
-    uv_unref((uv_handle_t*)&uv_edge_async->uv_async);
+    return V8SynchronizationContext::GetCurrentThreadId() == V8SynchronizationContext::v8ThreadId;
 }
 
 uv_edge_async_t* V8SynchronizationContext::RegisterAction(uv_async_edge_cb action, void* data)
 {
     DBG("V8SynchronizationContext::RegisterAction");
 
-    if (V8SynchronizationContext::GetCurrentThreadId() == V8SynchronizationContext::v8ThreadId)
+    uv_edge_async_t* uv_edge_async = new uv_edge_async_t;
+    uv_edge_async->action = action;
+    uv_edge_async->data = data;
+    uv_edge_async->next = NULL;
+
+    if (V8SynchronizationContext::IsOnV8Thread())
     {
         // This executes on V8 thread.
-        // Allocate new uv_edge_async.
+        // Keep the shared uv_async ref'd until this action is executed or cancelled.
         DBG("V8SynchronizationContext::RegisterAction on v8 thread");
-        uv_edge_async_t* uv_edge_async = new uv_edge_async_t;
-        uv_edge_async->action = action;
-        uv_edge_async->data = data;
-        uv_edge_async->singleton = FALSE;
-        uv_async_init(uv_default_loop(), &uv_edge_async->uv_async, (uv_async_cb)continueOnV8Thread);
-        return uv_edge_async;
+        uv_edge_async->keepAlive = TRUE;
+        if (V8SynchronizationContext::keepAliveCount++ == 0)
+        {
+            uv_ref((uv_handle_t*)V8SynchronizationContext::uv_async);
+        }
     }
     else
     {
         // This executes on CLR thread.
-        // Acquire exlusive access to uv_edge_async previously initialized on V8 thread.
         DBG("V8SynchronizationContext::RegisterAction on CLR thread");
-        uv_sem_wait(V8SynchronizationContext::funcWaitHandle);
-        V8SynchronizationContext::uv_edge_async->action = action;
-        V8SynchronizationContext::uv_edge_async->data = data;
-        return V8SynchronizationContext::uv_edge_async;
+        uv_edge_async->keepAlive = FALSE;
     }
+
+    return uv_edge_async;
 }
 
 void V8SynchronizationContext::ExecuteAction(uv_edge_async_t* uv_edge_async)
 {
     DBG("V8SynchronizationContext::ExecuteAction");
-    // Transfer control to continueOnV8Thread method executing on V8 thread
-    uv_async_send(&uv_edge_async->uv_async);
-}
 
-void close_uv_edge_async_cb(uv_handle_t* handle) {
-    uv_edge_async_t* uv_edge_async = (uv_edge_async_t*)handle;
-    delete uv_edge_async;
+    // Queue the action and transfer control to continueOnV8Thread method executing on V8 thread.
+    // Concurrent uv_async_send calls are coalesced by libuv, which is fine since continueOnV8Thread
+    // drains the whole queue.
+    while (!pushPendingAction(uv_edge_async));
+    uv_async_send(V8SynchronizationContext::uv_async);
 }
 
 void V8SynchronizationContext::CancelAction(uv_edge_async_t* uv_edge_async)
 {
+    // This executes on V8 thread
+
     DBG("V8SynchronizationContext::CancelAction");
-    if (uv_edge_async->singleton)
-    {
-        // This is a cancellation of an action registered on CLR thread.
-        // Release the wait handle to allow the uv_edge_async reuse by another CLR thread.
-        uv_edge_async->action = NULL;
-        uv_edge_async->data = NULL;
-        uv_sem_post(V8SynchronizationContext::funcWaitHandle);
-    }
-    else
+    if (uv_edge_async->keepAlive)
     {
         // This is a cancellation of an action registered on V8 thread.
-        // Unref the handle to stop preventing the process from exiting.
-        // V8SynchronizationContext::Unref(uv_edge_async);
-        uv_close((uv_handle_t*)&uv_edge_async->uv_async, close_uv_edge_async_cb);
+        // Unref the shared handle to stop preventing the process from exiting once no such
+        // actions remain.
+        if (--V8SynchronizationContext::keepAliveCount == 0)
+        {
+            uv_unref((uv_handle_t*)V8SynchronizationContext::uv_async);
+        }
     }
+
+    delete uv_edge_async;
 }
 
 unsigned long V8SynchronizationContext::GetCurrentThreadId()
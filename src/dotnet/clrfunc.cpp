@@ -11,12 +11,66 @@ NAN_METHOD(clrFuncProxy)
 {
     DBG("clrFuncProxy");
     Nan::HandleScope scope;
-    v8::Local<v8::External> correlator = v8::Local<v8::External>::Cast(info[2]);
-    ClrFuncWrap* wrap = (ClrFuncWrap*)(correlator->Value());
+    ClrFuncWrap* wrap = (ClrFuncWrap*)(info.Data().As<v8::External>()->Value());
     ClrFunc^ clrFunc = wrap->clrFunc;
+    if (clrFunc == nullptr)
+    {
+        return Nan::ThrowError("The CLR function has been disposed.");
+    }
+
     info.GetReturnValue().Set(clrFunc->Call(info[0], info[1]));
 }
 
+NAN_METHOD(clrFuncProxyDispose)
+{
+    DBG("clrFuncProxyDispose");
+    v8::Local<v8::Value> correlator = Nan::GetPrivate(info.This(), Nan::New<v8::String>("edge::clrFunc").ToLocalChecked()).ToLocalChecked();
+    if (!correlator->IsExternal())
+    {
+        // dispose was called on something else than a proxy
+        return;
+    }
+
+    ClrFuncWrap* wrap = (ClrFuncWrap*)(correlator.As<v8::External>()->Value());
+
+    // The wrap itself lives until the proxy is collected, calls made after disposal throw
+    wrap->clrFunc = nullptr;
+}
+
+void __cdecl clrFuncReleasePinnedBuffer(void* context)
+{
+    DBG("clrFuncReleasePinnedBuffer");
+    System::Runtime::InteropServices::GCHandle::FromIntPtr(System::IntPtr(context)).Free();
+}
+
+static System::Type^ GetTypedArrayElementType(TypedArrayType type)
+{
+    switch (type)
+    {
+        case TypedArrayTypeInt8: return System::SByte::typeid;
+        case TypedArrayTypeUint8:
+        case TypedArrayTypeUint8Clamped: return System::Byte::typeid;
+        case TypedArrayTypeInt16: return System::Int16::typeid;
+        case TypedArrayTypeUint16: return System::UInt16::typeid;
+        case TypedArrayTypeInt32: return System::Int32::typeid;
+        case TypedArrayTypeUint32: return System::UInt32::typeid;
+        case TypedArrayTypeFloat32: return System::Single::typeid;
+        default: return System::Double::typeid;
+    }
+}
+
+static TypedArrayType GetTypedArrayType(System::Type^ type)
+{
+    if (type == cli::array<double>::typeid) return TypedArrayTypeFloat64;
+    if (type == cli::array<float>::typeid) return TypedArrayTypeFloat32;
+    if (type == cli::array<int>::typeid) return TypedArrayTypeInt32;
+    if (type == cli::array<unsigned int>::typeid) return TypedArrayTypeUint32;
+    if (type == cli::array<short>::typeid) return TypedArrayTypeInt16;
+    if (type == cli::array<unsigned short>::typeid) return TypedArrayTypeUint16;
+    if (type == cli::array<signed char>::typeid) return TypedArrayTypeInt8;
+    return TypedArrayTypeNone;
+}
+
 template<typename T>
 void clrFuncProxyNearDeath(const Nan::WeakCallbackInfo<T> &data)
 {
@@ -30,8 +84,7 @@ v8::Local<v8::Function> ClrFunc::Initialize(System::Func<System::Object^,Task<Sy
 {
     DBG("ClrFunc::Initialize Func<object,Task<object>> wrapper");
 
-    static Nan::Persistent<v8::Function> proxyFactory;
-    static Nan::Persistent<v8::Function> proxyFunction;
+    static Nan::Persistent<v8::Function> proxyDisposeFunction;
 
     Nan::EscapableHandleScope scope;
 
@@ -40,21 +93,16 @@ v8::Local<v8::Function> ClrFunc::Initialize(System::Func<System::Object^,Task<Sy
     ClrFuncWrap* wrap = new ClrFuncWrap;
     wrap->clrFunc = app;
 
-    // See https://github.com/tjanczuk/edge/issues/128 for context
-
-    if (proxyFactory.IsEmpty())
+    if (proxyDisposeFunction.IsEmpty())
     {
-        v8::Local<v8::Function> clrFuncProxyFunction = Nan::New<v8::FunctionTemplate>(clrFuncProxy)->GetFunction();
-        proxyFunction.Reset(clrFuncProxyFunction);
-        v8::Local<v8::String> code = Nan::New<v8::String>(
-            "(function (f, ctx) { return function (d, cb) { return f(d, cb, ctx); }; })").ToLocalChecked();
-        v8::Local<v8::Function> codeFunction = v8::Local<v8::Function>::Cast(v8::Script::Compile(code)->Run());
-        proxyFactory.Reset(codeFunction);
+        proxyDisposeFunction.Reset(Nan::New<v8::FunctionTemplate>(clrFuncProxyDispose)->GetFunction());
     }
 
-    v8::Local<v8::Value> factoryArgv[] = { Nan::New(proxyFunction), Nan::New<v8::External>((void*)wrap) };
-    v8::Local<v8::Function> funcProxy =
-        (Nan::Call(Nan::New(proxyFactory), Nan::GetCurrentContext()->Global(), 2, factoryArgv)).ToLocalChecked().As<v8::Function>();
+    // The wrap is passed to clrFuncProxy as data of the proxy and kept in a private property for dispose
+    v8::Local<v8::External> correlator = Nan::New<v8::External>((void*)wrap);
+    v8::Local<v8::Function> funcProxy = Nan::New<v8::Function>(clrFuncProxy, correlator);
+    Nan::SetPrivate(funcProxy, Nan::New<v8::String>("edge::clrFunc").ToLocalChecked(), correlator);
+    Nan::Set(funcProxy, Nan::New<v8::String>("dispose").ToLocalChecked(), Nan::New(proxyDisposeFunction));
     Nan::Persistent<v8::Function> funcProxyPersistent(funcProxy);
     funcProxyPersistent.SetWeak((void*)wrap, &clrFuncProxyNearDeath, Nan::WeakCallbackType::kParameter);
 
@@ -145,7 +193,22 @@ v8::Local<v8::Value> ClrFunc::MarshalCLRToV8(System::Object^ netdata)
     System::Type^ type = netdata->GetType();
     if (type == System::String::typeid)
     {
-        jsdata = stringCLR2V8((System::String^)netdata);
+        System::String^ str = (System::String^)netdata;
+        if (minExternalStringLength > 0 && str->Length >= minExternalStringLength)
+        {
+            // Large strings are not copied, the pin is released when the external string is collected
+            System::Runtime::InteropServices::GCHandle pinnedHandle = System::Runtime::InteropServices::GCHandle::Alloc(
+                str, System::Runtime::InteropServices::GCHandleType::Pinned);
+            jsdata = NewExternalString(
+                (const uint16_t*)pinnedHandle.AddrOfPinnedObject().ToPointer(),
+                str->Length,
+                clrFuncReleasePinnedBuffer,
+                System::Runtime::InteropServices::GCHandle::ToIntPtr(pinnedHandle).ToPointer());
+        }
+        else
+        {
+            jsdata = stringCLR2V8(str);
+        }
     }
     else if (type == System::Char::typeid)
     {
@@ -232,7 +295,18 @@ v8::Local<v8::Value> ClrFunc::MarshalCLRToV8(System::Object^ netdata)
     else if (type == cli::array<byte>::typeid)
     {
         cli::array<byte>^ buffer = (cli::array<byte>^)netdata;
-        if (buffer->Length > 0)
+        if (enablePinnedByteArrays && buffer->Length >= EDGE_MIN_PINNED_BUFFER_LENGTH)
+        {
+            // Large arrays are not copied, the pin is released when the node.js Buffer is collected
+            System::Runtime::InteropServices::GCHandle pinnedHandle = System::Runtime::InteropServices::GCHandle::Alloc(
+                buffer, System::Runtime::InteropServices::GCHandleType::Pinned);
+            jsdata = NewExternalBuffer(
+                (char *)pinnedHandle.AddrOfPinnedObject().ToPointer(),
+                buffer->Length,
+                clrFuncReleasePinnedBuffer,
+                System::Runtime::InteropServices::GCHandle::ToIntPtr(pinnedHandle).ToPointer());
+        }
+        else if (buffer->Length > 0)
         {
             pin_ptr<unsigned char> pinnedBuffer = &buffer[0];
             jsdata = Nan::CopyBuffer((char *)pinnedBuffer, buffer->Length).ToLocalChecked();
@@ -242,6 +316,14 @@ v8::Local<v8::Value> ClrFunc::MarshalCLRToV8(System::Object^ netdata)
             jsdata = Nan::NewBuffer(0).ToLocalChecked();
         }
     }
+    else if (enableMarshalArrayAsTypedArray && GetTypedArrayType(type) != TypedArrayTypeNone)
+    {
+        System::Array^ netarray = (System::Array^)netdata;
+        System::Runtime::InteropServices::GCHandle pinnedHandle = System::Runtime::InteropServices::GCHandle::Alloc(
+            netarray, System::Runtime::InteropServices::GCHandleType::Pinned);
+        jsdata = NewTypedArray(GetTypedArrayType(type), pinnedHandle.AddrOfPinnedObject().ToPointer(), netarray->Length);
+        pinnedHandle.Free();
+    }
     else if (dynamic_cast<System::Collections::Generic::IDictionary<System::String^,System::Object^>^>(netdata) != nullptr)
     {
         v8::Local<v8::Object> result = Nan::New<v8::Object>();
@@ -401,6 +483,23 @@ System::Object^ ClrFunc::MarshalV8ToCLR(v8::Local<v8::Value> jsdata)
 
         return netfunc;
     }
+    // Every ArrayBufferView passes node::Buffer::HasInstance, so typed arrays are picked out first.
+    // Uint8Arrays, Buffers among them, keep marshaling as byte[].
+    else if (GetTypedArrayType(jsdata) != TypedArrayTypeNone && !jsdata->IsUint8Array())
+    {
+        v8::Local<v8::TypedArray> jsarray = v8::Local<v8::TypedArray>::Cast(jsdata);
+        System::Array^ netarray = System::Array::CreateInstance(
+            GetTypedArrayElementType(GetTypedArrayType(jsdata)), (int)jsarray->Length());
+        if (jsarray->Length() > 0)
+        {
+            System::Runtime::InteropServices::GCHandle pinnedHandle = System::Runtime::InteropServices::GCHandle::Alloc(
+                netarray, System::Runtime::InteropServices::GCHandleType::Pinned);
+            jsarray->CopyContents(pinnedHandle.AddrOfPinnedObject().ToPointer(), jsarray->ByteLength());
+            pinnedHandle.Free();
+        }
+
+        return netarray;
+    }
     else if (node::Buffer::HasInstance(jsdata))
     {
         v8::Local<v8::Object> jsbuffer = jsdata->ToObject();
@@ -10,12 +10,27 @@ ClrFuncReflectionWrap^ ClrFuncReflectionWrap::Create(
 {
     System::Type^ startupType = assembly->GetType(typeName, true, true);
     ClrFuncReflectionWrap^ wrap = gcnew ClrFuncReflectionWrap();
-    wrap->instance = System::Activator::CreateInstance(startupType, false);
-    wrap->invokeMethod = startupType->GetMethod(methodName, BindingFlags::Instance | BindingFlags::Public);
+    wrap->invokeMethod = startupType->GetMethod(methodName, BindingFlags::Instance | BindingFlags::Static | BindingFlags::Public);
     if (wrap->invokeMethod == nullptr) 
     {
         throw gcnew System::InvalidOperationException(
-            "Unable to access the CLR method to wrap through reflection. Make sure it is a public instance method.");
+            "Unable to access the CLR method to wrap through reflection. Make sure it is a public instance or static method.");
+    }
+
+    // Static methods are called without activating an instance of the type
+    if (!wrap->invokeMethod->IsStatic)
+    {
+        wrap->instance = System::Activator::CreateInstance(startupType, false);
+    }
+
+    // Methods with the exact Func<object, Task<object>> signature are called through a delegate instead of reflection
+    array<ParameterInfo^>^ parameters = wrap->invokeMethod->GetParameters();
+    if (parameters->Length == 1 
+        && parameters[0]->ParameterType == System::Object::typeid
+        && wrap->invokeMethod->ReturnType == Task<System::Object^>::typeid)
+    {
+        wrap->invokeFunc = (System::Func<System::Object^,Task<System::Object^>^>^)System::Delegate::CreateDelegate(
+            System::Func<System::Object^,Task<System::Object^>^>::typeid, wrap->instance, wrap->invokeMethod);
     }
     
     return wrap;
@@ -23,6 +38,11 @@ ClrFuncReflectionWrap^ ClrFuncReflectionWrap::Create(
 
 Task<System::Object^>^ ClrFuncReflectionWrap::Call(System::Object^ payload)
 {
+    if (this->invokeFunc != nullptr)
+    {
+        return this->invokeFunc(payload);
+    }
+
     return (Task<System::Object^>^)this->invokeMethod->Invoke(
                 this->instance, gcnew array<System::Object^> { payload });
 }
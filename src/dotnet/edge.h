@@ -115,6 +115,7 @@ ref class ClrFuncReflectionWrap {
 private:
     System::Object^ instance;
     MethodInfo^ invokeMethod;
+    System::Func<System::Object^,Task<System::Object^>^>^ invokeFunc;
 
     ClrFuncReflectionWrap();
 
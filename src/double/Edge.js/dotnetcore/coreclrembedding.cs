@@ -7,39 +7,17 @@ using System.Runtime.Loader;
 using System.Linq.Expressions;
 using System.Dynamic;
 using System.Collections.Generic;
+using System.Collections.Concurrent;
 using System.Collections;
 using System.Threading.Tasks;
 using System.IO;
 using System.Diagnostics;
+using System.Globalization;
 using Microsoft.Extensions.DependencyModel;
 using DotNetRuntimeEnvironment = Microsoft.DotNet.InternalAbstractions.RuntimeEnvironment;
 using Semver;
 
-[StructLayout(LayoutKind.Sequential)]
 // ReSharper disable once CheckNamespace
-public struct V8ObjectData
-{
-    public int propertiesCount;
-    public IntPtr propertyTypes;
-    public IntPtr propertyNames;
-    public IntPtr propertyValues;
-}
-
-[StructLayout(LayoutKind.Sequential)]
-public struct V8ArrayData
-{
-    public int arrayLength;
-    public IntPtr itemTypes;
-    public IntPtr itemValues;
-}
-
-[StructLayout(LayoutKind.Sequential)]
-public struct V8BufferData
-{
-    public int bufferLength;
-    public IntPtr buffer;
-}
-
 public enum V8Type
 {
     Function = 1,
@@ -54,7 +32,25 @@ public enum V8Type
     Number = 10,
     Null = 11,
     Task = 12,
-    Exception = 13
+    Exception = 13,
+    BufferView = 14,
+    ExternalString = 15,
+    TypedArray = 16,
+    PackedArray = 17,
+    ShapedObject = 18
+}
+
+public enum TypedArrayType
+{
+    Int8 = 1,
+    Uint8 = 2,
+    Uint8Clamped = 3,
+    Int16 = 4,
+    Uint16 = 5,
+    Int32 = 6,
+    Uint32 = 7,
+    Float32 = 8,
+    Float64 = 9
 }
 
 [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
@@ -68,26 +64,35 @@ public struct EdgeBootstrapperContext
 
     [MarshalAs(UnmanagedType.LPStr)]
     public string DependencyManifestFile;
+
+    public IntPtr AllocMarshalBlock;
+
+    public IntPtr ReallocMarshalBlock;
+
+    public IntPtr FreeMarshalBlock;
+
+    public IntPtr TaskComplete;
+
+    public IntPtr ReleaseV8Function;
+
+    public int MinExternalStringLength;
+
+    public int PinByteArrays;
 }
 
 public delegate void CallV8FunctionDelegate(IntPtr payload, int payloadType, IntPtr v8FunctionContext, IntPtr callbackContext, IntPtr callbackDelegate);
 public delegate void TaskCompleteDelegate(IntPtr result, int resultType, int taskState, IntPtr context);
+public delegate IntPtr AllocMarshalBlockDelegate(IntPtr size);
+public delegate IntPtr ReallocMarshalBlockDelegate(IntPtr block, IntPtr size);
+public delegate void FreeMarshalBlockDelegate(IntPtr block);
+public delegate void ReleaseV8FunctionDelegate(IntPtr v8FunctionContext);
+
+[UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+public delegate void ReleasePinnedBufferDelegate(IntPtr context);
 
 [SecurityCritical]
 public class CoreCLREmbedding
 {
-    private class TaskState
-    {
-        public readonly TaskCompleteDelegate Callback;
-        public readonly IntPtr Context;
-
-        public TaskState(TaskCompleteDelegate callback, IntPtr context)
-        {
-            Callback = callback;
-            Context = context;
-        }
-    }
-
     private class EdgeRuntimeEnvironment
     {
         public EdgeRuntimeEnvironment(EdgeBootstrapperContext bootstrapperContext)
@@ -416,11 +421,46 @@ public class CoreCLREmbedding
 
     private static readonly bool DebugMode = Environment.GetEnvironmentVariable("EDGE_DEBUG") == "1";
     private static readonly long MinDateTimeTicks = 621355968000000000;
-    private static readonly Dictionary<Type, List<Tuple<string, Func<object, object>>>> TypePropertyAccessors = new Dictionary<Type, List<Tuple<string, Func<object, object>>>>();
-    private static readonly int PointerSize = Marshal.SizeOf<IntPtr>();
-    private static readonly int V8BufferDataSize = Marshal.SizeOf<V8BufferData>();
-    private static readonly int V8ObjectDataSize = Marshal.SizeOf<V8ObjectData>();
-    private static readonly int V8ArrayDataSize = Marshal.SizeOf<V8ArrayData>();
+    private static readonly ConcurrentDictionary<Type, Lazy<ObjectShape>> ObjectShapes = new ConcurrentDictionary<Type, Lazy<ObjectShape>>();
+    private static readonly Action<Task<object>, object> TaskCompletedAction = TaskCompleted;
+    private static TaskCompleteDelegate TaskCompleteCallback;
+    private static readonly object True = true;
+    private static readonly object False = false;
+    private static readonly ConcurrentDictionary<Type, Lazy<ObjectBinder>> ObjectBinders = new ConcurrentDictionary<Type, Lazy<ObjectBinder>>();
+    private static readonly MethodInfo WriteInt32Method = typeof(MarshalWriter).GetTypeInfo().GetDeclaredMethod("WriteInt32");
+    private static readonly MethodInfo WriteStringMethod = typeof(MarshalWriter).GetTypeInfo().GetDeclaredMethod("WriteString");
+    private static readonly MethodInfo WriteTaggedInt32Method = typeof(CoreCLREmbedding).GetTypeInfo().GetDeclaredMethod("WriteTaggedInt32");
+    private static readonly MethodInfo WriteTaggedBooleanMethod = typeof(CoreCLREmbedding).GetTypeInfo().GetDeclaredMethod("WriteTaggedBoolean");
+    private static readonly MethodInfo WriteTaggedNumberMethod = typeof(CoreCLREmbedding).GetTypeInfo().GetDeclaredMethod("WriteTaggedNumber");
+    private static readonly MethodInfo WriteTaggedValueMethod = typeof(CoreCLREmbedding).GetTypeInfo().GetDeclaredMethod("WriteTaggedValue");
+    // Arrays this long are allocated on the large object heap, which is not compacted by default
+    private const int MinPinnedBufferLength = 85000;
+    private static bool PinByteArrays;
+    private static readonly ReleasePinnedBufferDelegate ReleasePinnedBufferCallback = ReleasePinnedBuffer;
+    private static readonly IntPtr ReleasePinnedBufferFunction = Marshal.GetFunctionPointerForDelegate(ReleasePinnedBufferCallback);
+    private static int MinExternalStringLength;
+    private static readonly bool MarshalArrayAsTypedArray = Environment.GetEnvironmentVariable("EDGE_MARSHAL_ARRAY_AS_TYPED_ARRAY") != null;
+    private static readonly Dictionary<Type, TypedArrayType> TypedArrayTypes = new Dictionary<Type, TypedArrayType>
+    {
+        { typeof(sbyte[]), TypedArrayType.Int8 },
+        { typeof(short[]), TypedArrayType.Int16 },
+        { typeof(ushort[]), TypedArrayType.Uint16 },
+        { typeof(int[]), TypedArrayType.Int32 },
+        { typeof(uint[]), TypedArrayType.Uint32 },
+        { typeof(float[]), TypedArrayType.Float32 },
+        { typeof(double[]), TypedArrayType.Float64 }
+    };
+    private static readonly Dictionary<Type, V8Type> PackedArrayTypes = new Dictionary<Type, V8Type>
+    {
+        { typeof(int[]), V8Type.Int32 },
+        { typeof(List<int>), V8Type.Int32 },
+        { typeof(double[]), V8Type.Number },
+        { typeof(List<double>), V8Type.Number },
+        { typeof(bool[]), V8Type.Boolean },
+        { typeof(List<bool>), V8Type.Boolean },
+        { typeof(string[]), V8Type.String },
+        { typeof(List<string>), V8Type.String }
+    };
     private static readonly Dictionary<string, Tuple<Type, MethodInfo>> Compilers = new Dictionary<string, Tuple<Type, MethodInfo>>();
 
     public static void Initialize(IntPtr context, IntPtr exception)
@@ -431,6 +471,11 @@ public class CoreCLREmbedding
 
             EdgeBootstrapperContext bootstrapperContext = Marshal.PtrToStructure<EdgeBootstrapperContext>(context);
 
+            MarshalWriter.SetAllocator(bootstrapperContext.AllocMarshalBlock, bootstrapperContext.ReallocMarshalBlock, bootstrapperContext.FreeMarshalBlock);
+            TaskCompleteCallback = Marshal.GetDelegateForFunctionPointer<TaskCompleteDelegate>(bootstrapperContext.TaskComplete);
+            NodejsFunc.ReleaseV8Function = Marshal.GetDelegateForFunctionPointer<ReleaseV8FunctionDelegate>(bootstrapperContext.ReleaseV8Function);
+            MinExternalStringLength = bootstrapperContext.MinExternalStringLength;
+            PinByteArrays = bootstrapperContext.PinByteArrays != 0;
             RuntimeEnvironment = new EdgeRuntimeEnvironment(bootstrapperContext);
             Resolver = new EdgeAssemblyResolver();
 
@@ -621,7 +666,7 @@ public class CoreCLREmbedding
     }
 
     [SecurityCritical]
-    public static void CallFunc(IntPtr function, IntPtr payload, int payloadType, IntPtr taskState, IntPtr result, IntPtr resultType)
+    public static void CallFunc(IntPtr function, IntPtr payload, int payloadType, long scalarPayload, IntPtr taskState, IntPtr result, IntPtr resultType, IntPtr scalarResult)
     {
         try
         {
@@ -630,8 +675,15 @@ public class CoreCLREmbedding
             GCHandle wrapperHandle = GCHandle.FromIntPtr(function);
             Func<object, Task<object>> wrapperFunc = (Func<object, Task<object>>)wrapperHandle.Target;
 
+            // Payloads of methods with a typed parameter are bound directly to that type
+            ClrFuncReflectionWrap wrapper = wrapperFunc.Target as ClrFuncReflectionWrap;
+            Type parameterType = wrapper != null ? wrapper.ParameterType : typeof(object);
+
             DebugMessage("CoreCLREmbedding::CallFunc (CLR) - Marshalling data of type {0} and calling the .NET method", ((V8Type)payloadType).ToString("G"));
-            Task<Object> functionTask = wrapperFunc(MarshalV8ToCLR(payload, (V8Type)payloadType));
+            object payloadObject = payload == IntPtr.Zero
+                ? ConvertValue(ScalarToCLR((V8Type)payloadType, scalarPayload), parameterType)
+                : MarshalV8ToCLR(payload, (V8Type)payloadType, parameterType);
+            Task<Object> functionTask = wrapperFunc(payloadObject);
 
             if (functionTask.IsFaulted)
             {
@@ -649,7 +701,17 @@ public class CoreCLREmbedding
                 DebugMessage("CoreCLREmbedding::CallFunc (CLR) - .NET method ran synchronously, marshalling data for V8");
 
                 V8Type taskResultType;
-                IntPtr marshalData = MarshalCLRToV8(functionTask.Result, out taskResultType);
+                long scalar;
+                IntPtr marshalData = IntPtr.Zero;
+
+                if (ScalarToV8(functionTask.Result, out taskResultType, out scalar))
+                {
+                    Marshal.WriteInt64(scalarResult, scalar);
+                }
+                else
+                {
+                    marshalData = MarshalCLRToV8(functionTask.Result, out taskResultType);
+                }
 
                 DebugMessage("CoreCLREmbedding::CallFunc (CLR) - Method return data is of type {0}", taskResultType.ToString("G"));
 
@@ -684,13 +746,89 @@ public class CoreCLREmbedding
         }
     }
 
+    // Scalar payloads and synchronous results are passed by value next to a null data pointer, see CallFuncFunction in edge.h
+    private static object ScalarToCLR(V8Type scalarType, long scalar)
+    {
+        switch (scalarType)
+        {
+            case V8Type.Boolean:
+                return scalar != 0 ? True : False;
+
+            case V8Type.Int32:
+                return (int)scalar;
+
+            case V8Type.UInt32:
+                return (uint)scalar;
+
+            case V8Type.Number:
+                return BitConverter.Int64BitsToDouble(scalar);
+
+            default:
+                return null;
+        }
+    }
+
+    private static bool ScalarToV8(object clrObject, out V8Type scalarType, out long scalar)
+    {
+        if (clrObject == null)
+        {
+            scalarType = V8Type.Null;
+            scalar = 0;
+        }
+
+        else if (clrObject is bool)
+        {
+            scalarType = V8Type.Boolean;
+            scalar = (bool)clrObject ? 1 : 0;
+        }
+
+        else if (clrObject is int)
+        {
+            scalarType = V8Type.Int32;
+            scalar = (int)clrObject;
+        }
+
+        else if (clrObject is short)
+        {
+            scalarType = V8Type.Int32;
+            scalar = (short)clrObject;
+        }
+
+        else if (clrObject is double)
+        {
+            scalarType = V8Type.Number;
+            scalar = BitConverter.DoubleToInt64Bits((double)clrObject);
+        }
+
+        else if (clrObject is long)
+        {
+            scalarType = V8Type.Number;
+            scalar = BitConverter.DoubleToInt64Bits((long)clrObject);
+        }
+
+        else if (clrObject is float)
+        {
+            scalarType = V8Type.Number;
+            scalar = BitConverter.DoubleToInt64Bits((float)clrObject);
+        }
+
+        else
+        {
+            scalarType = V8Type.Null;
+            scalar = 0;
+
+            return false;
+        }
+
+        return true;
+    }
+
     private static void TaskCompleted(Task<object> task, object state)
     {
         DebugMessage("CoreCLREmbedding::TaskCompleted (CLR) - Task completed with a state of {0}", task.Status.ToString("G"));
         DebugMessage("CoreCLREmbedding::TaskCompleted (CLR) - Marshalling data to return to V8", task.Status.ToString("G"));
 
         V8Type v8Type;
-        TaskState actualState = (TaskState)state;
         IntPtr resultObject;
         TaskStatus taskStatus;
 
@@ -727,11 +865,11 @@ public class CoreCLREmbedding
         }
 
         DebugMessage("CoreCLREmbedding::TaskCompleted (CLR) - Invoking unmanaged callback");
-        actualState.Callback(resultObject, (int)v8Type, (int)taskStatus, actualState.Context);
+        TaskCompleteCallback(resultObject, (int)v8Type, (int)taskStatus, (IntPtr)state);
     }
 
     [SecurityCritical]
-    public static void ContinueTask(IntPtr task, IntPtr context, IntPtr callback, IntPtr exception)
+    public static void ContinueTask(IntPtr task, IntPtr context, IntPtr exception)
     {
         try
         {
@@ -739,13 +877,12 @@ public class CoreCLREmbedding
 
             DebugMessage("CoreCLREmbedding::ContinueTask (CLR) - Starting");
 
+            // The continuation keeps the task alive, so the handle passed to V8 is released right away
             GCHandle taskHandle = GCHandle.FromIntPtr(task);
             Task<Object> actualTask = (Task<Object>)taskHandle.Target;
+            taskHandle.Free();
 
-            TaskCompleteDelegate taskCompleteDelegate = Marshal.GetDelegateForFunctionPointer<TaskCompleteDelegate>(callback);
-            DebugMessage("CoreCLREmbedding::ContinueTask (CLR) - Marshalled unmanaged callback successfully");
-
-            actualTask.ContinueWith(TaskCompleted, new TaskState(taskCompleteDelegate, context));
+            actualTask.ContinueWith(TaskCompletedAction, context);
 
             DebugMessage("CoreCLREmbedding::ContinueTask (CLR) - Finished");
         }
@@ -777,115 +914,82 @@ public class CoreCLREmbedding
         }
     }
 
-    [SecurityCritical]
-    public static void FreeMarshalData(IntPtr marshalData, int v8Type)
+    private static void ReleasePinnedBuffer(IntPtr context)
     {
-        switch ((V8Type)v8Type)
-        {
-            case V8Type.String:
-            case V8Type.Int32:
-            case V8Type.Boolean:
-            case V8Type.Number:
-            case V8Type.Date:
-                Marshal.FreeHGlobal(marshalData);
-                break;
-
-            case V8Type.Object:
-            case V8Type.Exception:
-                V8ObjectData objectData = Marshal.PtrToStructure<V8ObjectData>(marshalData);
-
-                for (int i = 0; i < objectData.propertiesCount; i++)
-                {
-                    int propertyType = Marshal.ReadInt32(objectData.propertyTypes, i * sizeof(int));
-                    IntPtr propertyValue = Marshal.ReadIntPtr(objectData.propertyValues, i * PointerSize);
-                    IntPtr propertyName = Marshal.ReadIntPtr(objectData.propertyNames, i * PointerSize);
-
-                    FreeMarshalData(propertyValue, propertyType);
-                    Marshal.FreeHGlobal(propertyName);
-                }
-
-                Marshal.FreeHGlobal(objectData.propertyTypes);
-                Marshal.FreeHGlobal(objectData.propertyValues);
-                Marshal.FreeHGlobal(objectData.propertyNames);
-                Marshal.FreeHGlobal(marshalData);
-
-                break;
-
-            case V8Type.Array:
-                V8ArrayData arrayData = Marshal.PtrToStructure<V8ArrayData>(marshalData);
-
-                for (int i = 0; i < arrayData.arrayLength; i++)
-                {
-                    int itemType = Marshal.ReadInt32(arrayData.itemTypes, i * sizeof(int));
-                    IntPtr itemValue = Marshal.ReadIntPtr(arrayData.itemValues, i * PointerSize);
-
-                    FreeMarshalData(itemValue, itemType);
-                }
-
-                Marshal.FreeHGlobal(arrayData.itemTypes);
-                Marshal.FreeHGlobal(arrayData.itemValues);
-                Marshal.FreeHGlobal(marshalData);
-
-                break;
-
-            case V8Type.Buffer:
-                V8BufferData bufferData = Marshal.PtrToStructure<V8BufferData>(marshalData);
-
-                Marshal.FreeHGlobal(bufferData.buffer);
-                Marshal.FreeHGlobal(marshalData);
-
-                break;
+        DebugMessage("CoreCLREmbedding::ReleasePinnedBuffer (CLR) - Releasing pinned buffer");
+        GCHandle.FromIntPtr(context).Free();
+    }
 
-            case V8Type.Null:
-            case V8Type.Function:
-                break;
+    // ReSharper disable once InconsistentNaming
+    public static IntPtr MarshalCLRToV8(object clrObject, out V8Type v8Type)
+    {
+        MarshalWriter writer = MarshalWriter.Acquire();
 
-            default:
-                throw new Exception("Unsupported marshalled data type: " + v8Type);
+        try
+        {
+            v8Type = MarshalCLRToV8(writer, clrObject);
         }
+        catch
+        {
+            writer.Discard();
+            throw;
+        }
+
+        return writer.Detach();
     }
 
     // ReSharper disable once InconsistentNaming
-    public static IntPtr MarshalCLRToV8(object clrObject, out V8Type v8Type)
+    private static V8Type MarshalCLRToV8(MarshalWriter writer, object clrObject)
     {
         if (clrObject == null)
         {
-            v8Type = V8Type.Null;
-            return IntPtr.Zero;
+            return V8Type.Null;
         }
 
         else if (clrObject is string)
         {
-            v8Type = V8Type.String;
-            return Marshal.StringToHGlobalAnsi((string) clrObject);
+            string value = (string) clrObject;
+
+            if (MinExternalStringLength > 0 && value.Length >= MinExternalStringLength)
+            {
+                // Large strings are not copied, V8 gets an external string over the pinned characters
+                // that releases the pin when the string is collected
+                GCHandle stringHandle = GCHandle.Alloc(value, GCHandleType.Pinned);
+
+                writer.WriteInt32(value.Length);
+                writer.WriteIntPtr(stringHandle.AddrOfPinnedObject());
+                writer.WriteIntPtr(ReleasePinnedBufferFunction);
+                writer.WritePinnedHandle(stringHandle);
+
+                return V8Type.ExternalString;
+            }
+
+            writer.WriteString(value);
+            return V8Type.String;
         }
 
         else if (clrObject is char)
         {
-            v8Type = V8Type.String;
-            return Marshal.StringToHGlobalAnsi(clrObject.ToString());
+            writer.WriteString(clrObject.ToString());
+            return V8Type.String;
         }
 
         else if (clrObject is bool)
         {
-            v8Type = V8Type.Boolean;
-            IntPtr memoryLocation = Marshal.AllocHGlobal(sizeof (int));
-
-            Marshal.WriteInt32(memoryLocation, ((bool) clrObject)
+            writer.WriteInt32(((bool) clrObject)
                 ? 1
                 : 0);
-            return memoryLocation;
+            return V8Type.Boolean;
         }
 
         else if (clrObject is Guid)
         {
-            v8Type = V8Type.String;
-            return Marshal.StringToHGlobalAnsi(clrObject.ToString());
+            writer.WriteString(clrObject.ToString());
+            return V8Type.String;
         }
 
         else if (clrObject is DateTime)
         {
-            v8Type = V8Type.Date;
             DateTime dateTime = (DateTime) clrObject;
 
             if (dateTime.Kind == DateTimeKind.Local)
@@ -899,113 +1003,124 @@ public class CoreCLREmbedding
             }
 
             long ticks = (dateTime.Ticks - MinDateTimeTicks)/10000;
-            IntPtr memoryLocation = Marshal.AllocHGlobal(sizeof (double));
 
-            WriteDouble(memoryLocation, ticks);
-            return memoryLocation;
+            writer.WriteDouble(ticks);
+            return V8Type.Date;
         }
 
         else if (clrObject is DateTimeOffset)
         {
-            v8Type = V8Type.String;
-            return Marshal.StringToHGlobalAnsi(clrObject.ToString());
+            writer.WriteString(clrObject.ToString());
+            return V8Type.String;
         }
 
         else if (clrObject is Uri)
         {
-            v8Type = V8Type.String;
-            return Marshal.StringToHGlobalAnsi(clrObject.ToString());
+            writer.WriteString(clrObject.ToString());
+            return V8Type.String;
         }
 
         else if (clrObject is short)
         {
-            v8Type = V8Type.Int32;
-            IntPtr memoryLocation = Marshal.AllocHGlobal(sizeof (int));
-
-            Marshal.WriteInt32(memoryLocation, Convert.ToInt32(clrObject));
-            return memoryLocation;
+            writer.WriteInt32(Convert.ToInt32(clrObject));
+            return V8Type.Int32;
         }
 
         else if (clrObject is int)
         {
-            v8Type = V8Type.Int32;
-            IntPtr memoryLocation = Marshal.AllocHGlobal(sizeof (int));
-
-            Marshal.WriteInt32(memoryLocation, (int) clrObject);
-            return memoryLocation;
+            writer.WriteInt32((int) clrObject);
+            return V8Type.Int32;
         }
 
         else if (clrObject is long)
         {
-            v8Type = V8Type.Number;
-            IntPtr memoryLocation = Marshal.AllocHGlobal(sizeof (double));
-
-            WriteDouble(memoryLocation, Convert.ToDouble((long) clrObject));
-            return memoryLocation;
+            writer.WriteDouble(Convert.ToDouble((long) clrObject));
+            return V8Type.Number;
         }
 
         else if (clrObject is double)
         {
-            v8Type = V8Type.Number;
-            IntPtr memoryLocation = Marshal.AllocHGlobal(sizeof (double));
-
-            WriteDouble(memoryLocation, (double) clrObject);
-            return memoryLocation;
+            writer.WriteDouble((double) clrObject);
+            return V8Type.Number;
         }
 
         else if (clrObject is float)
         {
-            v8Type = V8Type.Number;
-            IntPtr memoryLocation = Marshal.AllocHGlobal(sizeof (double));
-
-            WriteDouble(memoryLocation, Convert.ToDouble((Single) clrObject));
-            return memoryLocation;
+            writer.WriteDouble(Convert.ToDouble((Single) clrObject));
+            return V8Type.Number;
         }
 
         else if (clrObject is decimal)
         {
-            v8Type = V8Type.String;
-            return Marshal.StringToHGlobalAnsi(clrObject.ToString());
+            writer.WriteString(clrObject.ToString());
+            return V8Type.String;
         }
 
         else if (clrObject is Enum)
         {
-            v8Type = V8Type.String;
-            return Marshal.StringToHGlobalAnsi(clrObject.ToString());
+            writer.WriteString(clrObject.ToString());
+            return V8Type.String;
         }
 
         else if (clrObject is byte[] || clrObject is IEnumerable<byte>)
         {
-            v8Type = V8Type.Buffer;
-
-            V8BufferData bufferData = new V8BufferData();
             byte[] buffer;
+            int offset = 0;
+            int count;
 
             if (clrObject is byte[])
             {
                 buffer = (byte[]) clrObject;
+                count = buffer.Length;
+            }
+
+            else if (clrObject is ArraySegment<byte>)
+            {
+                ArraySegment<byte> segment = (ArraySegment<byte>) clrObject;
+
+                buffer = segment.Array;
+                offset = segment.Offset;
+                count = segment.Count;
             }
 
             else
             {
                 buffer = ((IEnumerable<byte>) clrObject).ToArray();
+                count = buffer.Length;
             }
 
-            bufferData.bufferLength = buffer.Length;
-            bufferData.buffer = Marshal.AllocHGlobal(buffer.Length*sizeof (byte));
+            if (PinByteArrays && count >= MinPinnedBufferLength)
+            {
+                // Large buffers are not copied, node.js gets an external Buffer over the pinned array
+                // that releases the pin when the Buffer is collected
+                GCHandle bufferHandle = GCHandle.Alloc(buffer, GCHandleType.Pinned);
 
-            Marshal.Copy(buffer, 0, bufferData.buffer, bufferData.bufferLength);
+                writer.WriteInt32(count);
+                writer.WriteIntPtr(IntPtr.Add(bufferHandle.AddrOfPinnedObject(), offset));
+                writer.WriteIntPtr(ReleasePinnedBufferFunction);
+                writer.WritePinnedHandle(bufferHandle);
 
-            IntPtr destinationPointer = Marshal.AllocHGlobal(V8BufferDataSize);
-            Marshal.StructureToPtr(bufferData, destinationPointer, false);
+                return V8Type.BufferView;
+            }
 
-            return destinationPointer;
+            writer.WriteBytes(buffer, offset, count);
+            return V8Type.Buffer;
         }
 
-        else if (clrObject is IDictionary || clrObject is ExpandoObject)
+        else if (MarshalArrayAsTypedArray && TypedArrayTypes.ContainsKey(clrObject.GetType()))
         {
-            v8Type = V8Type.Object;
+            writer.WriteTypedArray(TypedArrayTypes[clrObject.GetType()], (Array) clrObject);
+            return V8Type.TypedArray;
+        }
 
+        else if (PackedArrayTypes.ContainsKey(clrObject.GetType()) && !(clrObject is IList<string> && ((IList<string>) clrObject).Contains(null)))
+        {
+            WritePackedArray(writer, PackedArrayTypes[clrObject.GetType()], clrObject);
+            return V8Type.PackedArray;
+        }
+
+        else if (clrObject is IDictionary || clrObject is ExpandoObject)
+        {
             IEnumerable keys;
             int keyCount;
             Func<object, object> getValue;
@@ -1028,57 +1143,34 @@ public class CoreCLREmbedding
                 getValue = index => objectDictionary[index];
             }
 
-            V8ObjectData objectData = new V8ObjectData();
-            int counter = 0;
-
-            objectData.propertiesCount = keyCount;
-            objectData.propertyNames = Marshal.AllocHGlobal(PointerSize*keyCount);
-            objectData.propertyTypes = Marshal.AllocHGlobal(sizeof (int)*keyCount);
-            objectData.propertyValues = Marshal.AllocHGlobal(PointerSize*keyCount);
+            writer.WriteInt32(keyCount);
 
             foreach (object key in keys)
             {
-                Marshal.WriteIntPtr(objectData.propertyNames, counter*PointerSize, Marshal.StringToHGlobalAnsi(key.ToString()));
-                V8Type propertyType;
-                Marshal.WriteIntPtr(objectData.propertyValues, counter*PointerSize, MarshalCLRToV8(getValue(key), out propertyType));
-                Marshal.WriteInt32(objectData.propertyTypes, counter*sizeof (int), (int) propertyType);
+                writer.WriteString(key.ToString());
 
-                counter++;
+                int propertyTypeOffset = writer.ReserveInt32();
+                writer.WriteInt32At(propertyTypeOffset, (int) MarshalCLRToV8(writer, getValue(key)));
             }
 
-            IntPtr destinationPointer = Marshal.AllocHGlobal(V8ObjectDataSize);
-            Marshal.StructureToPtr(objectData, destinationPointer, false);
-
-            return destinationPointer;
+            return V8Type.Object;
         }
 
         else if (clrObject is IEnumerable)
         {
-            v8Type = V8Type.Array;
-
-            V8ArrayData arrayData = new V8ArrayData();
-            List<IntPtr> itemValues = new List<IntPtr>();
-            List<int> itemTypes = new List<int>();
+            int arrayLengthOffset = writer.ReserveInt32();
+            int arrayLength = 0;
 
             foreach (object item in (IEnumerable) clrObject)
             {
-                V8Type itemType;
+                int itemTypeOffset = writer.ReserveInt32();
+                writer.WriteInt32At(itemTypeOffset, (int) MarshalCLRToV8(writer, item));
 
-                itemValues.Add(MarshalCLRToV8(item, out itemType));
-                itemTypes.Add((int) itemType);
+                arrayLength++;
             }
 
-            arrayData.arrayLength = itemValues.Count;
-            arrayData.itemTypes = Marshal.AllocHGlobal(sizeof (int)*arrayData.arrayLength);
-            arrayData.itemValues = Marshal.AllocHGlobal(PointerSize*arrayData.arrayLength);
-
-            Marshal.Copy(itemTypes.ToArray(), 0, arrayData.itemTypes, arrayData.arrayLength);
-            Marshal.Copy(itemValues.ToArray(), 0, arrayData.itemValues, arrayData.arrayLength);
-
-            IntPtr destinationPointer = Marshal.AllocHGlobal(V8ArrayDataSize);
-            Marshal.StructureToPtr(arrayData, destinationPointer, false);
-
-            return destinationPointer;
+            writer.WriteInt32At(arrayLengthOffset, arrayLength);
+            return V8Type.Array;
         }
 
         else if (clrObject.GetType().GetTypeInfo().IsGenericType && clrObject.GetType().GetGenericTypeDefinition() == typeof (Func<,>))
@@ -1090,13 +1182,13 @@ public class CoreCLREmbedding
                 throw new Exception("Properties that return Func<> instances must return Func<object, Task<object>> instances");
             }
 
-            v8Type = V8Type.Function;
-            return GCHandle.ToIntPtr(GCHandle.Alloc(funcObject));
+            writer.WriteIntPtr(GCHandle.ToIntPtr(GCHandle.Alloc(funcObject)));
+            return V8Type.Function;
         }
 
         else
         {
-            v8Type = clrObject is Exception
+            V8Type v8Type = clrObject is Exception
                 ? V8Type.Exception
                 : V8Type.Object;
 
@@ -1120,90 +1212,201 @@ public class CoreCLREmbedding
                 }
             }
 
-            List<Tuple<string, Func<object, object>>> propertyAccessors = GetPropertyAccessors(clrObject.GetType());
-            V8ObjectData objectData = new V8ObjectData();
-            int counter = 0;
+            ObjectShape shape = GetObjectShape(clrObject.GetType());
 
-            objectData.propertiesCount = propertyAccessors.Count;
-            objectData.propertyNames = Marshal.AllocHGlobal(PointerSize*propertyAccessors.Count);
-            objectData.propertyTypes = Marshal.AllocHGlobal(sizeof (int)*propertyAccessors.Count);
-            objectData.propertyValues = Marshal.AllocHGlobal(PointerSize*propertyAccessors.Count);
-
-            foreach (Tuple<string, Func<object, object>> propertyAccessor in propertyAccessors)
+            if (v8Type == V8Type.Object)
             {
-                Marshal.WriteIntPtr(objectData.propertyNames, counter*PointerSize, Marshal.StringToHGlobalAnsi(propertyAccessor.Item1));
-
-                V8Type propertyType;
+                // Property names were sent once with the shape descriptor, only the values follow
+                writer.WriteIntPtr(shape.Descriptor);
+                shape.Serialize(writer, clrObject);
 
-                Marshal.WriteIntPtr(objectData.propertyValues, counter*PointerSize, MarshalCLRToV8(propertyAccessor.Item2(clrObject), out propertyType));
-                Marshal.WriteInt32(objectData.propertyTypes, counter*sizeof (int), (int) propertyType);
-                counter++;
+                return V8Type.ShapedObject;
             }
 
-            IntPtr destinationPointer = Marshal.AllocHGlobal(V8ObjectDataSize);
-            Marshal.StructureToPtr(objectData, destinationPointer, false);
+            // Serializers of exceptions write the property names inline
+            shape.Serialize(writer, clrObject);
+            return v8Type;
+        }
+    }
+
+    // Lists of int, double, bool and non-null strings are sent without per item tags
+    private static void WritePackedArray(MarshalWriter writer, V8Type itemType, object clrObject)
+    {
+        writer.WriteInt32((int) itemType);
+
+        switch (itemType)
+        {
+            case V8Type.Int32:
+                IList<int> ints = (IList<int>) clrObject;
+                writer.WriteInt32(ints.Count);
+
+                for (int i = 0; i < ints.Count; i++)
+                {
+                    writer.WriteInt32(ints[i]);
+                }
+
+                break;
+
+            case V8Type.Number:
+                IList<double> doubles = (IList<double>) clrObject;
+                writer.WriteInt32(doubles.Count);
+
+                for (int i = 0; i < doubles.Count; i++)
+                {
+                    writer.WriteDouble(doubles[i]);
+                }
+
+                break;
+
+            case V8Type.Boolean:
+                IList<bool> bools = (IList<bool>) clrObject;
+                writer.WriteInt32(bools.Count);
 
-            return destinationPointer;
+                for (int i = 0; i < bools.Count; i++)
+                {
+                    writer.WriteInt32(bools[i] ? 1 : 0);
+                }
+
+                break;
+
+            default:
+                IList<string> strings = (IList<string>) clrObject;
+                writer.WriteInt32(strings.Count);
+
+                for (int i = 0; i < strings.Count; i++)
+                {
+                    writer.WriteString(strings[i]);
+                }
+
+                break;
         }
     }
 
     public static object MarshalV8ToCLR(IntPtr v8Object, V8Type objectType)
+    {
+        MarshalReader reader = new MarshalReader(v8Object);
+        return MarshalV8ToCLR(ref reader, objectType);
+    }
+
+    public static object MarshalV8ToCLR(IntPtr v8Object, V8Type objectType, Type targetType)
+    {
+        MarshalReader reader = new MarshalReader(v8Object);
+        return MarshalV8ToCLR(ref reader, objectType, targetType);
+    }
+
+    // Binds the V8 value to the target type: objects are deserialized into instances of the type or into
+    // a Dictionary<string, object>, arrays into arrays or lists of the element type and primitives are converted.
+    private static object MarshalV8ToCLR(ref MarshalReader reader, V8Type objectType, Type targetType)
+    {
+        if (targetType == typeof(object))
+        {
+            return MarshalV8ToCLR(ref reader, objectType);
+        }
+
+        switch (objectType)
+        {
+            case V8Type.Object:
+                if (targetType.IsAssignableFrom(typeof(Dictionary<string, object>)))
+                {
+                    return V8ObjectToDictionary(ref reader);
+                }
+
+                ObjectBinder binder = GetObjectBinder(targetType);
+
+                if (binder != null)
+                {
+                    return V8ObjectToInstance(ref reader, binder);
+                }
+
+                break;
+
+            case V8Type.Array:
+                Type elementType = GetCollectionElementType(targetType);
+
+                if (elementType != null)
+                {
+                    int arrayLength = reader.ReadInt32();
+                    Array array = Array.CreateInstance(elementType, arrayLength);
+
+                    for (int i = 0; i < arrayLength; i++)
+                    {
+                        V8Type itemType = (V8Type)reader.ReadInt32();
+                        array.SetValue(MarshalV8ToCLR(ref reader, itemType, elementType), i);
+                    }
+
+                    return ToCollection(array, targetType);
+                }
+
+                break;
+        }
+
+        return ConvertValue(MarshalV8ToCLR(ref reader, objectType), targetType);
+    }
+
+    private static object MarshalV8ToCLR(ref MarshalReader reader, V8Type objectType)
     {
         switch (objectType)
         {
             case V8Type.String:
-                return Marshal.PtrToStringAnsi(v8Object);
+                return reader.ReadString();
 
             case V8Type.Object:
-                return V8ObjectToExpando(Marshal.PtrToStructure<V8ObjectData>(v8Object));
+                return V8ObjectToExpando(ref reader);
 
             case V8Type.Boolean:
-                return Marshal.ReadByte(v8Object) != 0;
+                return reader.ReadInt32() != 0;
 
             case V8Type.Number:
-                return ReadDouble(v8Object);
+                return reader.ReadDouble();
 
             case V8Type.Date:
-                double ticks = ReadDouble(v8Object);
+                double ticks = reader.ReadDouble();
                 return new DateTime(Convert.ToInt64(ticks) * 10000 + MinDateTimeTicks, DateTimeKind.Utc);
 
             case V8Type.Null:
                 return null;
 
             case V8Type.Int32:
-                return Marshal.ReadInt32(v8Object);
+                return reader.ReadInt32();
 
             case V8Type.UInt32:
-                return (uint)Marshal.ReadInt32(v8Object);
+                return (uint)reader.ReadInt32();
 
             case V8Type.Function:
-                NodejsFunc nodejsFunc = new NodejsFunc(v8Object);
+                NodejsFunc nodejsFunc = new NodejsFunc(reader.ReadIntPtr());
                 return nodejsFunc.GetFunc();
 
             case V8Type.Array:
-                V8ArrayData arrayData = Marshal.PtrToStructure<V8ArrayData>(v8Object);
-                object[] array = new object[arrayData.arrayLength];
+                int arrayLength = reader.ReadInt32();
+                object[] array = new object[arrayLength];
 
-                for (int i = 0; i < arrayData.arrayLength; i++)
+                for (int i = 0; i < arrayLength; i++)
                 {
-                    int itemType = Marshal.ReadInt32(arrayData.itemTypes, i * sizeof(int));
-                    IntPtr itemValuePointer = Marshal.ReadIntPtr(arrayData.itemValues, i * PointerSize);
-
-                    array[i] = MarshalV8ToCLR(itemValuePointer, (V8Type)itemType);
+                    V8Type itemType = (V8Type)reader.ReadInt32();
+                    array[i] = MarshalV8ToCLR(ref reader, itemType);
                 }
 
                 return array;
 
             case V8Type.Buffer:
-                V8BufferData bufferData = Marshal.PtrToStructure<V8BufferData>(v8Object);
-                byte[] buffer = new byte[bufferData.bufferLength];
+                return reader.ReadBytes(reader.ReadInt32());
+
+            case V8Type.BufferView:
+                int bufferLength = reader.ReadInt32();
+                IntPtr buffer = reader.ReadIntPtr();
+                IntPtr release = reader.ReadIntPtr();
+                IntPtr releaseContext = reader.ReadIntPtr();
+
+                return new NativeBufferStream(buffer, bufferLength, release, releaseContext);
 
-                Marshal.Copy(bufferData.buffer, buffer, 0, bufferData.bufferLength);
+            case V8Type.TypedArray:
+                return reader.ReadTypedArray();
 
-                return buffer;
+            case V8Type.PackedArray:
+                return V8PackedArrayToArray(ref reader);
 
             case V8Type.Exception:
-                string message = Marshal.PtrToStringAnsi(v8Object);
+                string message = reader.ReadString();
                 return new Exception(message);
 
             default:
@@ -1211,89 +1414,193 @@ public class CoreCLREmbedding
         }
     }
 
-    private static unsafe void WriteDouble(IntPtr pointer, double value)
+    private static Array V8PackedArrayToArray(ref MarshalReader reader)
     {
-        try
+        V8Type itemType = (V8Type)reader.ReadInt32();
+        int arrayLength = reader.ReadInt32();
+
+        switch (itemType)
         {
-            byte* address = (byte*)pointer;
+            case V8Type.Int32:
+                int[] ints = new int[arrayLength];
 
-            if ((unchecked((int)address) & 0x7) == 0)
-            {
-                *((double*)address) = value;
-            }
+                for (int i = 0; i < arrayLength; i++)
+                {
+                    ints[i] = reader.ReadInt32();
+                }
 
-            else
-            {
-                byte* valuePointer = (byte*)&value;
-
-                address[0] = valuePointer[0];
-                address[1] = valuePointer[1];
-                address[2] = valuePointer[2];
-                address[3] = valuePointer[3];
-                address[4] = valuePointer[4];
-                address[5] = valuePointer[5];
-                address[6] = valuePointer[6];
-                address[7] = valuePointer[7];
-            }
+                return ints;
+
+            case V8Type.Number:
+                double[] doubles = new double[arrayLength];
+
+                for (int i = 0; i < arrayLength; i++)
+                {
+                    doubles[i] = reader.ReadDouble();
+                }
+
+                return doubles;
+
+            case V8Type.Boolean:
+                bool[] bools = new bool[arrayLength];
+
+                for (int i = 0; i < arrayLength; i++)
+                {
+                    bools[i] = reader.ReadInt32() != 0;
+                }
+
+                return bools;
+
+            default:
+                string[] strings = new string[arrayLength];
+
+                for (int i = 0; i < arrayLength; i++)
+                {
+                    strings[i] = reader.ReadString();
+                }
+
+                return strings;
+        }
+    }
+
+    private static ExpandoObject V8ObjectToExpando(ref MarshalReader reader)
+    {
+        ExpandoObject expando = new ExpandoObject();
+        IDictionary<string, object> expandoDictionary = expando;
+        int propertiesCount = reader.ReadInt32();
+
+        for (int i = 0; i < propertiesCount; i++)
+        {
+            string propertyName = reader.ReadPropertyName();
+            V8Type propertyType = (V8Type)reader.ReadInt32();
+
+            expandoDictionary.Add(propertyName, MarshalV8ToCLR(ref reader, propertyType));
         }
 
-        catch (NullReferenceException)
+        return expando;
+    }
+
+    private static Dictionary<string, object> V8ObjectToDictionary(ref MarshalReader reader)
+    {
+        int propertiesCount = reader.ReadInt32();
+        Dictionary<string, object> dictionary = new Dictionary<string, object>(propertiesCount);
+
+        for (int i = 0; i < propertiesCount; i++)
         {
-            throw new Exception("Access violation.");
+            string propertyName = reader.ReadPropertyName();
+            V8Type propertyType = (V8Type)reader.ReadInt32();
+
+            dictionary[propertyName] = MarshalV8ToCLR(ref reader, propertyType);
         }
+
+        return dictionary;
     }
 
-    private static unsafe double ReadDouble(IntPtr pointer)
+    private static object V8ObjectToInstance(ref MarshalReader reader, ObjectBinder binder)
     {
-        try
+        object instance = binder.Create();
+        int propertiesCount = reader.ReadInt32();
+
+        for (int i = 0; i < propertiesCount; i++)
         {
-            byte* address = (byte*)pointer;
+            string propertyName = reader.ReadPropertyName();
+            V8Type propertyType = (V8Type)reader.ReadInt32();
+            MemberBinder member;
 
-            if ((unchecked((int)address) & 0x7) == 0)
+            if (binder.Members.TryGetValue(propertyName, out member))
             {
-                return *((double*)address);
+                object value = MarshalV8ToCLR(ref reader, propertyType, member.Type);
+
+                // Nulls leave members of value types at their defaults
+                if (value != null || member.AcceptsNull)
+                {
+                    member.Set(instance, value);
+                }
             }
 
             else
             {
-                double value;
-                byte* valuePointer = (byte*)&value;
-
-                valuePointer[0] = address[0];
-                valuePointer[1] = address[1];
-                valuePointer[2] = address[2];
-                valuePointer[3] = address[3];
-                valuePointer[4] = address[4];
-                valuePointer[5] = address[5];
-                valuePointer[6] = address[6];
-                valuePointer[7] = address[7];
-
-                return value;
+                // Properties without a matching member still have to be read past
+                MarshalV8ToCLR(ref reader, propertyType);
+            }
+        }
+
+        return instance;
+    }
+
+    // Converts primitive values and arrays to the target type, values that cannot be converted are returned as is
+    private static object ConvertValue(object value, Type targetType)
+    {
+        if (value == null || targetType.IsAssignableFrom(value.GetType()))
+        {
+            return value;
+        }
+
+        Type elementType = GetCollectionElementType(targetType);
+        Array array = value as Array;
+
+        if (array != null && elementType != null)
+        {
+            Array convertedArray = Array.CreateInstance(elementType, array.Length);
+
+            for (int i = 0; i < array.Length; i++)
+            {
+                convertedArray.SetValue(ConvertValue(array.GetValue(i), elementType), i);
             }
+
+            return ToCollection(convertedArray, targetType);
+        }
+
+        Type underlyingType = Nullable.GetUnderlyingType(targetType) ?? targetType;
+        TypeInfo underlyingTypeInfo = underlyingType.GetTypeInfo();
+
+        if (underlyingTypeInfo.IsEnum)
+        {
+            string name = value as string;
+
+            return name != null
+                ? Enum.Parse(underlyingType, name, true)
+                : Enum.ToObject(underlyingType, Convert.ChangeType(value, Enum.GetUnderlyingType(underlyingType)));
         }
 
-        catch (NullReferenceException)
+        if (value is IConvertible && typeof(IConvertible).IsAssignableFrom(underlyingType))
         {
-            throw new Exception("Access violation.");
+            return Convert.ChangeType(value, underlyingType, CultureInfo.InvariantCulture);
         }
+
+        return value;
     }
 
-    private static ExpandoObject V8ObjectToExpando(V8ObjectData v8Object)
+    private static Type GetCollectionElementType(Type type)
     {
-        ExpandoObject expando = new ExpandoObject();
-        IDictionary<string, object> expandoDictionary = expando;
+        if (type.IsArray)
+        {
+            return type.GetArrayRank() == 1 ? type.GetElementType() : null;
+        }
 
-        for (int i = 0; i < v8Object.propertiesCount; i++)
+        TypeInfo typeInfo = type.GetTypeInfo();
+
+        if (!typeInfo.IsGenericType)
         {
-            int propertyType = Marshal.ReadInt32(v8Object.propertyTypes, i * sizeof(int));
-            IntPtr propertyNamePointer = Marshal.ReadIntPtr(v8Object.propertyNames, i * PointerSize);
-            string propertyName = Marshal.PtrToStringAnsi(propertyNamePointer);
-            IntPtr propertyValuePointer = Marshal.ReadIntPtr(v8Object.propertyValues, i * PointerSize);
+            return null;
+        }
+
+        Type genericType = type.GetGenericTypeDefinition();
 
-            expandoDictionary.Add(propertyName, MarshalV8ToCLR(propertyValuePointer, (V8Type)propertyType));
+        if (genericType == typeof(List<>) || genericType == typeof(IList<>) || genericType == typeof(ICollection<>) ||
+            genericType == typeof(IEnumerable<>) || genericType == typeof(IReadOnlyList<>) || genericType == typeof(IReadOnlyCollection<>))
+        {
+            return typeInfo.GenericTypeArguments[0];
         }
 
-        return expando;
+        return null;
+    }
+
+    private static object ToCollection(Array array, Type collectionType)
+    {
+        return collectionType.IsAssignableFrom(array.GetType())
+            ? array
+            : Activator.CreateInstance(collectionType, array);
     }
     
     internal static void DebugMessage(string message, params object[] parameters)
@@ -1304,42 +1611,240 @@ public class CoreCLREmbedding
         }
     }
 
-    private static List<Tuple<string, Func<object, object>>> GetPropertyAccessors(Type type)
+    private static ObjectBinder GetObjectBinder(Type type)
     {
-        if (TypePropertyAccessors.ContainsKey(type))
+        return ObjectBinders.GetOrAdd(type, t => new Lazy<ObjectBinder>(() => CreateObjectBinder(t))).Value;
+    }
+
+    // Compiles the constructor and member setters used to deserialize V8 objects into instances of the type.
+    // Members are matched to property names ignoring case, so camelCase JavaScript names bind to PascalCase members.
+    private static ObjectBinder CreateObjectBinder(Type type)
+    {
+        TypeInfo typeInfo = type.GetTypeInfo();
+
+        if (!typeInfo.IsClass || typeInfo.IsAbstract || type == typeof(string) || typeof(IEnumerable).IsAssignableFrom(type) ||
+            !typeInfo.DeclaredConstructors.Any(c => c.IsPublic && !c.IsStatic && c.GetParameters().Length == 0))
         {
-            return TypePropertyAccessors[type];
+            return null;
         }
 
-        List<Tuple<string, Func<object, object>>> propertyAccessors = new List<Tuple<string, Func<object, object>>>();
+        DebugMessage("CoreCLREmbedding::CreateObjectBinder (CLR) - Compiling deserializer for {0}", type.FullName);
+
+        Dictionary<string, MemberBinder> members = new Dictionary<string, MemberBinder>(StringComparer.OrdinalIgnoreCase);
+        ParameterExpression instance = Expression.Parameter(typeof(object));
+        ParameterExpression value = Expression.Parameter(typeof(object));
+        Expression typedInstance = Expression.Convert(instance, type);
 
         foreach (PropertyInfo propertyInfo in type.GetProperties(BindingFlags.Instance | BindingFlags.Public))
         {
-            ParameterExpression instance = Expression.Parameter(typeof(object));
-            UnaryExpression instanceConvert = Expression.TypeAs(instance, type);
-            MemberExpression property = Expression.Property(instanceConvert, propertyInfo);
-            UnaryExpression propertyConvert = Expression.TypeAs(property, typeof(object));
+            if (propertyInfo.SetMethod != null && propertyInfo.SetMethod.IsPublic && propertyInfo.GetIndexParameters().Length == 0 && !members.ContainsKey(propertyInfo.Name))
+            {
+                members.Add(propertyInfo.Name, CreateMemberBinder(Expression.Property(typedInstance, propertyInfo), propertyInfo.PropertyType, instance, value));
+            }
+        }
+
+        foreach (FieldInfo fieldInfo in type.GetFields(BindingFlags.Instance | BindingFlags.Public))
+        {
+            if (!fieldInfo.IsInitOnly && !members.ContainsKey(fieldInfo.Name))
+            {
+                members.Add(fieldInfo.Name, CreateMemberBinder(Expression.Field(typedInstance, fieldInfo), fieldInfo.FieldType, instance, value));
+            }
+        }
+
+        Func<object> create = Expression.Lambda<Func<object>>(Expression.Convert(Expression.New(type), typeof(object))).Compile();
+
+        return new ObjectBinder(create, members);
+    }
+
+    private static MemberBinder CreateMemberBinder(MemberExpression member, Type memberType, ParameterExpression instance, ParameterExpression value)
+    {
+        Action<object, object> set = Expression.Lambda<Action<object, object>>(
+            Expression.Assign(member, Expression.Convert(value, memberType)), instance, value).Compile();
+
+        return new MemberBinder(memberType, set);
+    }
+
+    private static ObjectShape GetObjectShape(Type type)
+    {
+        return ObjectShapes.GetOrAdd(type, t => new Lazy<ObjectShape>(() => CreateObjectShape(t))).Value;
+    }
+
+    // Compiles a serializer that writes the tagged values of all public properties and fields of the type.
+    // Properties of primitive types are written without boxing them.
+    private static ObjectShape CreateObjectShape(Type type)
+    {
+        DebugMessage("CoreCLREmbedding::CreateObjectShape (CLR) - Compiling serializer for {0}", type.FullName);
+
+        bool isException = typeof(Exception).IsAssignableFrom(type);
+        ParameterExpression writer = Expression.Parameter(typeof(MarshalWriter));
+        ParameterExpression instance = Expression.Parameter(typeof(object));
+        ParameterExpression typedInstance = Expression.Variable(type);
+        List<string> names = new List<string>();
+        List<Expression> values = new List<Expression>();
 
-            propertyAccessors.Add(new Tuple<string, Func<object, object>>(propertyInfo.Name, (Func<object, object>)Expression.Lambda(propertyConvert, instance).Compile()));
+        foreach (PropertyInfo propertyInfo in type.GetProperties(BindingFlags.Instance | BindingFlags.Public))
+        {
+            names.Add(propertyInfo.Name);
+            values.Add(Expression.Property(typedInstance, propertyInfo));
         }
 
         foreach (FieldInfo fieldInfo in type.GetFields(BindingFlags.Instance | BindingFlags.Public))
         {
-            ParameterExpression instance = Expression.Parameter(typeof(object));
-            UnaryExpression instanceConvert = Expression.TypeAs(instance, type);
-            MemberExpression field = Expression.Field(instanceConvert, fieldInfo);
-            UnaryExpression fieldConvert = Expression.TypeAs(field, typeof(object));
+            names.Add(fieldInfo.Name);
+            values.Add(Expression.Field(typedInstance, fieldInfo));
+        }
+
+        if (isException && !names.Contains("Name"))
+        {
+            names.Add("Name");
+            values.Add(Expression.Constant(type.FullName));
+        }
+
+        List<Expression> body = new List<Expression>
+        {
+            Expression.Assign(typedInstance, Expression.Convert(instance, type))
+        };
 
-            propertyAccessors.Add(new Tuple<string, Func<object, object>>(fieldInfo.Name, (Func<object, object>)Expression.Lambda(fieldConvert, instance).Compile()));
+        if (isException)
+        {
+            body.Add(Expression.Call(writer, WriteInt32Method, Expression.Constant(names.Count)));
         }
 
-        if (typeof(Exception).IsAssignableFrom(type) && !propertyAccessors.Any(a => a.Item1 == "Name"))
+        for (int i = 0; i < names.Count; i++)
         {
-            propertyAccessors.Add(new Tuple<string, Func<object, object>>("Name", o => type.FullName));
+            if (isException)
+            {
+                body.Add(Expression.Call(writer, WriteStringMethod, Expression.Constant(names[i])));
+            }
+
+            body.Add(WriteTaggedValueExpression(writer, values[i]));
         }
 
-        TypePropertyAccessors[type] = propertyAccessors;
+        Action<MarshalWriter, object> serialize = Expression.Lambda<Action<MarshalWriter, object>>(
+            Expression.Block(new[] { typedInstance }, body), writer, instance).Compile();
+
+        return new ObjectShape(isException ? null : names, serialize);
+    }
 
-        return propertyAccessors;
+    private static Expression WriteTaggedValueExpression(ParameterExpression writer, Expression value)
+    {
+        if (value.Type == typeof(int) || value.Type == typeof(short))
+        {
+            return Expression.Call(WriteTaggedInt32Method, writer, Expression.Convert(value, typeof(int)));
+        }
+
+        if (value.Type == typeof(bool))
+        {
+            return Expression.Call(WriteTaggedBooleanMethod, writer, value);
+        }
+
+        if (value.Type == typeof(double) || value.Type == typeof(long) || value.Type == typeof(float))
+        {
+            return Expression.Call(WriteTaggedNumberMethod, writer, Expression.Convert(value, typeof(double)));
+        }
+
+        return Expression.Call(WriteTaggedValueMethod, writer, Expression.Convert(value, typeof(object)));
+    }
+
+    private static void WriteTaggedInt32(MarshalWriter writer, int value)
+    {
+        writer.WriteInt32((int) V8Type.Int32);
+        writer.WriteInt32(value);
+    }
+
+    private static void WriteTaggedBoolean(MarshalWriter writer, bool value)
+    {
+        writer.WriteInt32((int) V8Type.Boolean);
+        writer.WriteInt32(value ? 1 : 0);
+    }
+
+    private static void WriteTaggedNumber(MarshalWriter writer, double value)
+    {
+        writer.WriteInt32((int) V8Type.Number);
+        writer.WriteDouble(value);
+    }
+
+    private static void WriteTaggedValue(MarshalWriter writer, object value)
+    {
+        int valueTypeOffset = writer.ReserveInt32();
+        writer.WriteInt32At(valueTypeOffset, (int) MarshalCLRToV8(writer, value));
+    }
+}
+
+// Serializer of a CLR type marshaled to V8 as an object. The property names of types other than exceptions
+// are written once into a native descriptor that is never freed, V8 identifies the shape by its address.
+internal sealed class ObjectShape
+{
+    public ObjectShape(List<string> propertyNames, Action<MarshalWriter, object> serialize)
+    {
+        if (propertyNames != null)
+        {
+            MarshalWriter writer = MarshalWriter.Acquire();
+
+            writer.WriteInt32(propertyNames.Count);
+
+            foreach (string propertyName in propertyNames)
+            {
+                writer.WriteString(propertyName);
+            }
+
+            Descriptor = writer.Detach();
+        }
+
+        Serialize = serialize;
+    }
+
+    public IntPtr Descriptor
+    {
+        get;
+    }
+
+    public Action<MarshalWriter, object> Serialize
+    {
+        get;
+    }
+}
+
+internal sealed class ObjectBinder
+{
+    public ObjectBinder(Func<object> create, Dictionary<string, MemberBinder> members)
+    {
+        Create = create;
+        Members = members;
+    }
+
+    public Func<object> Create
+    {
+        get;
+    }
+
+    public Dictionary<string, MemberBinder> Members
+    {
+        get;
+    }
+}
+
+internal sealed class MemberBinder
+{
+    public MemberBinder(Type type, Action<object, object> set)
+    {
+        Type = type;
+        AcceptsNull = !type.GetTypeInfo().IsValueType || Nullable.GetUnderlyingType(type) != null;
+        Set = set;
+    }
+
+    public Type Type
+    {
+        get;
+    }
+
+    public bool AcceptsNull
+    {
+        get;
+    }
+
+    public Action<object, object> Set
+    {
+        get;
     }
 }
@@ -0,0 +1,380 @@
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+// Writes values in the flat marshaling format shared with CoreCLREmbedding/edge.h. Values are written
+// straight into a block allocated by the native module, which grows it in place where it can and
+// releases it without calling back into the CLR.
+internal sealed unsafe class MarshalWriter
+{
+    private const int InitialCapacity = 64;
+
+    private static AllocMarshalBlockDelegate allocMarshalBlock;
+    private static ReallocMarshalBlockDelegate reallocMarshalBlock;
+    private static FreeMarshalBlockDelegate freeMarshalBlock;
+
+    [ThreadStatic]
+    private static MarshalWriter cachedWriter;
+
+    private byte* data;
+    private int length;
+    private int capacity;
+    private List<GCHandle> pinnedHandles;
+
+    private MarshalWriter()
+    {
+    }
+
+    public static void SetAllocator(IntPtr allocMarshalBlockFunction, IntPtr reallocMarshalBlockFunction, IntPtr freeMarshalBlockFunction)
+    {
+        allocMarshalBlock = Marshal.GetDelegateForFunctionPointer<AllocMarshalBlockDelegate>(allocMarshalBlockFunction);
+        reallocMarshalBlock = Marshal.GetDelegateForFunctionPointer<ReallocMarshalBlockDelegate>(reallocMarshalBlockFunction);
+        freeMarshalBlock = Marshal.GetDelegateForFunctionPointer<FreeMarshalBlockDelegate>(freeMarshalBlockFunction);
+    }
+
+    public static MarshalWriter Acquire()
+    {
+        // Marshaling can be reentered on the same thread, the cached writer is handed out only once
+        MarshalWriter writer = cachedWriter ?? new MarshalWriter();
+        cachedWriter = null;
+
+        return writer;
+    }
+
+    public IntPtr Detach()
+    {
+        IntPtr result = (IntPtr)data;
+
+        // Null values are passed without allocating any memory
+        if (length == 0 && data != null)
+        {
+            freeMarshalBlock(result);
+            result = IntPtr.Zero;
+        }
+
+        Reset();
+
+        return result;
+    }
+
+    // Releases what has been written so far, for when marshaling fails halfway
+    public void Discard()
+    {
+        if (data != null)
+        {
+            freeMarshalBlock((IntPtr)data);
+        }
+
+        if (pinnedHandles != null)
+        {
+            foreach (GCHandle pinnedHandle in pinnedHandles)
+            {
+                pinnedHandle.Free();
+            }
+        }
+
+        Reset();
+    }
+
+    public int ReserveInt32()
+    {
+        Reserve(sizeof(int));
+
+        return length - sizeof(int);
+    }
+
+    public void WriteInt32At(int offset, int value)
+    {
+        *(int*)(data + offset) = value;
+    }
+
+    public void WriteInt32(int value)
+    {
+        *(int*)Reserve(sizeof(int)) = value;
+    }
+
+    public void WriteDouble(double value)
+    {
+        byte* destination = Reserve(sizeof(double));
+        byte* source = (byte*)&value;
+
+        for (int i = 0; i < sizeof(double); i++)
+        {
+            destination[i] = source[i];
+        }
+    }
+
+    public void WriteIntPtr(IntPtr value)
+    {
+        *(IntPtr*)Reserve(IntPtr.Size) = value;
+    }
+
+    // Pinned handles are released by the reader, or by Discard if the data never reaches it
+    public void WritePinnedHandle(GCHandle value)
+    {
+        WriteIntPtr(GCHandle.ToIntPtr(value));
+
+        if (pinnedHandles == null)
+        {
+            pinnedHandles = new List<GCHandle>();
+        }
+
+        pinnedHandles.Add(value);
+    }
+
+    public void WriteString(string value)
+    {
+        // Strings are copied as UTF-16 code units, V8 decides on its own representation when creating the string
+        int byteCount = value.Length * sizeof(char);
+
+        WriteInt32(value.Length << 1);
+
+        byte* destination = Reserve(byteCount);
+
+        fixed (char* source = value)
+        {
+            Buffer.MemoryCopy(source, destination, byteCount, byteCount);
+        }
+    }
+
+    public void WriteBytes(byte[] value, int offset, int count)
+    {
+        WriteInt32(count);
+        Marshal.Copy(value, offset, (IntPtr)Reserve(count), count);
+    }
+
+    public void WriteTypedArray(TypedArrayType type, Array value)
+    {
+        int byteCount = Buffer.ByteLength(value);
+
+        WriteInt32((int) type);
+        WriteInt32(value.Length);
+
+        byte* destination = Reserve(byteCount);
+
+        if (byteCount > 0)
+        {
+            GCHandle valueHandle = GCHandle.Alloc(value, GCHandleType.Pinned);
+
+            try
+            {
+                Buffer.MemoryCopy((void*)valueHandle.AddrOfPinnedObject(), destination, byteCount, byteCount);
+            }
+            finally
+            {
+                valueHandle.Free();
+            }
+        }
+    }
+
+    private byte* Reserve(int size)
+    {
+        if (length + size > capacity)
+        {
+            int newCapacity = capacity == 0 ? InitialCapacity : capacity * 2;
+
+            while (length + size > newCapacity)
+            {
+                newCapacity *= 2;
+            }
+
+            data = (byte*)(data == null
+                ? allocMarshalBlock((IntPtr)newCapacity)
+                : reallocMarshalBlock((IntPtr)data, (IntPtr)newCapacity));
+            capacity = newCapacity;
+        }
+
+        byte* position = data + length;
+        length += size;
+
+        return position;
+    }
+
+    private void Reset()
+    {
+        data = null;
+        length = 0;
+        capacity = 0;
+        pinnedHandles?.Clear();
+        cachedWriter = this;
+    }
+}
+
+// Reads values in the flat marshaling format shared with CoreCLREmbedding/edge.h.
+internal unsafe struct MarshalReader
+{
+    private const int CachedPropertyNameHeader = -1;
+
+    private byte* position;
+
+    public MarshalReader(IntPtr data)
+    {
+        position = (byte*)data;
+    }
+
+    public int ReadInt32()
+    {
+        int value = *(int*)position;
+        position += sizeof(int);
+
+        return value;
+    }
+
+    public double ReadDouble()
+    {
+        double value;
+        byte* destination = (byte*)&value;
+
+        for (int i = 0; i < sizeof(double); i++)
+        {
+            destination[i] = position[i];
+        }
+
+        position += sizeof(double);
+
+        return value;
+    }
+
+    public IntPtr ReadIntPtr()
+    {
+        IntPtr value = *(IntPtr*)position;
+        position += IntPtr.Size;
+
+        return value;
+    }
+
+    public string ReadString()
+    {
+        return ReadString(ReadInt32());
+    }
+
+    // Property names are either strings or records of names V8 sees repeatedly. The record keeps
+    // a handle to the CLR string read first, so every payload shares one string instance per name.
+    public string ReadPropertyName()
+    {
+        int header = ReadInt32();
+
+        if (header != CachedPropertyNameHeader)
+        {
+            return ReadString(header);
+        }
+
+        IntPtr* record = (IntPtr*)ReadIntPtr();
+        IntPtr nameHandle = Volatile.Read(ref *record);
+
+        if (nameHandle != IntPtr.Zero)
+        {
+            return (string)GCHandle.FromIntPtr(nameHandle).Target;
+        }
+
+        MarshalReader recordReader = new MarshalReader((IntPtr)(record + 1));
+        string name = recordReader.ReadString();
+
+        nameHandle = GCHandle.ToIntPtr(GCHandle.Alloc(name));
+
+        if (Interlocked.CompareExchange(ref *record, nameHandle, IntPtr.Zero) != IntPtr.Zero)
+        {
+            GCHandle.FromIntPtr(nameHandle).Free();
+        }
+
+        return name;
+    }
+
+    private string ReadString(int header)
+    {
+        int count = header >> 1;
+        string value;
+
+        if ((header & 1) == 0)
+        {
+            value = new string((char*)position, 0, count);
+            position += count * sizeof(char);
+        }
+        else
+        {
+            // Latin-1 is widened straight into the new string
+            value = new string('\0', count);
+
+            fixed (char* destination = value)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    destination[i] = (char)position[i];
+                }
+            }
+
+            position += count;
+        }
+
+        return value;
+    }
+
+    public byte[] ReadBytes(int count)
+    {
+        byte[] value = new byte[count];
+
+        Marshal.Copy((IntPtr)position, value, 0, count);
+        position += count;
+
+        return value;
+    }
+
+    public Array ReadTypedArray()
+    {
+        TypedArrayType type = (TypedArrayType)ReadInt32();
+        int count = ReadInt32();
+        Array value;
+
+        switch (type)
+        {
+            case TypedArrayType.Int8:
+                value = new sbyte[count];
+                break;
+            case TypedArrayType.Uint8:
+            case TypedArrayType.Uint8Clamped:
+                value = new byte[count];
+                break;
+            case TypedArrayType.Int16:
+                value = new short[count];
+                break;
+            case TypedArrayType.Uint16:
+                value = new ushort[count];
+                break;
+            case TypedArrayType.Int32:
+                value = new int[count];
+                break;
+            case TypedArrayType.Uint32:
+                value = new uint[count];
+                break;
+            case TypedArrayType.Float32:
+                value = new float[count];
+                break;
+            case TypedArrayType.Float64:
+                value = new double[count];
+                break;
+            default:
+                throw new Exception("Unsupported TypedArray type: " + type + ".");
+        }
+
+        int byteCount = Buffer.ByteLength(value);
+
+        if (byteCount > 0)
+        {
+            GCHandle valueHandle = GCHandle.Alloc(value, GCHandleType.Pinned);
+
+            try
+            {
+                Buffer.MemoryCopy(position, (void*)valueHandle.AddrOfPinnedObject(), byteCount, byteCount);
+            }
+            finally
+            {
+                valueHandle.Free();
+            }
+        }
+
+        position += byteCount;
+
+        return value;
+    }
+}
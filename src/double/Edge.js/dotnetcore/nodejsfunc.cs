@@ -10,6 +10,12 @@ public class NodejsFunc
         private set; 
     }
 
+    internal static ReleaseV8FunctionDelegate ReleaseV8Function
+    {
+        get;
+        set;
+    }
+
     public NodejsFunc(IntPtr context)
     {
         Context = context;
@@ -17,7 +23,8 @@ public class NodejsFunc
 
     ~NodejsFunc()
     {
-        // TODO: implement release
+        // The native function is only queued for release here, the V8 thread releases queued functions in batches
+        ReleaseV8Function(Context);
     }
 
     public Func<object, Task<object>> GetFunc()
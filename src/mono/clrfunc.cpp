@@ -5,19 +5,104 @@
 #include "mono/jit/jit.h"
 
 
-ClrFunc::ClrFunc()
+int ClrFunc::liveCount = 0;
+
+ClrFunc::ClrFunc() : func(0), offload(false), promise(false), bufferMode(BufferMarshalModeCopy), references(1)
+{
+    liveCount++;
+}
+
+ClrFunc::~ClrFunc()
+{
+    DBG("ClrFunc::~ClrFunc");
+    if (this->func)
+    {
+        mono_gchandle_free(this->func);
+        this->func = 0;
+    }
+
+    liveCount--;
+}
+
+int ClrFunc::GetLiveCount()
+{
+    return liveCount;
+}
+
+void ClrFunc::AddRef()
+{
+    this->references++;
+}
+
+void ClrFunc::Release(ClrFunc* function)
 {
-    // empty
+    if (function && --function->references == 0)
+    {
+        delete function;
+    }
 }
 
 NAN_METHOD(clrFuncProxy)
 {
     DBG("clrFuncProxy");
     Nan::HandleScope scope;
-    v8::Local<v8::External> correlator = v8::Local<v8::External>::Cast(info[2]);
-    ClrFuncWrap* wrap = (ClrFuncWrap*)(correlator->Value());
+    ClrFuncWrap* wrap = (ClrFuncWrap*)(info.Data().As<v8::External>()->Value());
     ClrFunc* clrFunc = wrap->clrFunc;
+    if (!clrFunc)
+    {
+        return Nan::ThrowError("The CLR function has been disposed.");
+    }
+
+    // Node.js functions called inline by the CLR may dispose the proxy before Call returns
+    clrFunc->AddRef();
     info.GetReturnValue().Set(clrFunc->Call(info[0], info[1]));
+    ClrFunc::Release(clrFunc);
+}
+
+NAN_METHOD(clrFuncProxyDispose)
+{
+    DBG("clrFuncProxyDispose");
+    v8::Local<v8::Value> correlator = Nan::GetPrivate(info.This(), Nan::New<v8::String>("edge::clrFunc").ToLocalChecked()).ToLocalChecked();
+    if (!correlator->IsExternal())
+    {
+        // dispose was called on something else than a proxy
+        return;
+    }
+
+    ClrFuncWrap* wrap = (ClrFuncWrap*)(correlator.As<v8::External>()->Value());
+
+    // The wrap itself lives until the proxy is collected, calls made after disposal throw.
+    // Offloaded calls in progress hold on to the managed function on their own.
+    ClrFunc::Release(wrap->clrFunc);
+    wrap->clrFunc = NULL;
+}
+
+static MonoClass* GetTypedArrayElementClass(TypedArrayType type)
+{
+    switch (type)
+    {
+        case TypedArrayTypeInt8: return mono_get_sbyte_class();
+        case TypedArrayTypeUint8:
+        case TypedArrayTypeUint8Clamped: return mono_get_byte_class();
+        case TypedArrayTypeInt16: return mono_get_int16_class();
+        case TypedArrayTypeUint16: return mono_get_uint16_class();
+        case TypedArrayTypeInt32: return mono_get_int32_class();
+        case TypedArrayTypeUint32: return mono_get_uint32_class();
+        case TypedArrayTypeFloat32: return mono_get_single_class();
+        default: return mono_get_double_class();
+    }
+}
+
+static TypedArrayType GetTypedArrayType(MonoClass* elementClass)
+{
+    if (elementClass == mono_get_double_class()) return TypedArrayTypeFloat64;
+    if (elementClass == mono_get_single_class()) return TypedArrayTypeFloat32;
+    if (elementClass == mono_get_int32_class()) return TypedArrayTypeInt32;
+    if (elementClass == mono_get_uint32_class()) return TypedArrayTypeUint32;
+    if (elementClass == mono_get_int16_class()) return TypedArrayTypeInt16;
+    if (elementClass == mono_get_uint16_class()) return TypedArrayTypeUint16;
+    if (elementClass == mono_get_sbyte_class()) return TypedArrayTypeInt8;
+    return TypedArrayTypeNone;
 }
 
 template<typename T>
@@ -25,40 +110,37 @@ void clrFuncProxyNearDeath(const Nan::WeakCallbackInfo<T> &data)
 {
     DBG("clrFuncProxyNearDeath");
     ClrFuncWrap* wrap = (ClrFuncWrap*)(data.GetParameter());
-    delete wrap->clrFunc; 
+    ClrFunc::Release(wrap->clrFunc);
     wrap->clrFunc = NULL;
     delete wrap;
 }
 
-v8::Local<v8::Function> ClrFunc::Initialize(MonoObject* func)
+v8::Local<v8::Function> ClrFunc::Initialize(MonoObject* func, bool offload, bool promise, BufferMarshalMode bufferMode)
 {
     DBG("ClrFunc::Initialize Func<object,Task<object>> wrapper");
 
-    static Nan::Persistent<v8::Function> proxyFactory;
-    static Nan::Persistent<v8::Function> proxyFunction;    
+    static Nan::Persistent<v8::Function> proxyDisposeFunction;
 
     Nan::EscapableHandleScope scope;
 
     ClrFunc* app = new ClrFunc();
     app->func = mono_gchandle_new(func, FALSE);
+    app->offload = offload;
+    app->promise = promise;
+    app->bufferMode = bufferMode;
     ClrFuncWrap* wrap = new ClrFuncWrap;
     wrap->clrFunc = app;
 
-    // See https://github.com/tjanczuk/edge/issues/128 for context
-    
-    if (proxyFactory.IsEmpty())
+    if (proxyDisposeFunction.IsEmpty())
     {
-        v8::Local<v8::Function> clrFuncProxyFunction = Nan::New<v8::FunctionTemplate>(clrFuncProxy)->GetFunction();
-        proxyFunction.Reset(clrFuncProxyFunction);
-        v8::Local<v8::String> code = Nan::New<v8::String>(
-            "(function (f, ctx) { return function (d, cb) { return f(d, cb, ctx); }; })").ToLocalChecked();
-        v8::Local<v8::Function> codeFunction = v8::Local<v8::Function>::Cast(v8::Script::Compile(code)->Run());
-        proxyFactory.Reset(codeFunction);
+        proxyDisposeFunction.Reset(Nan::New<v8::FunctionTemplate>(clrFuncProxyDispose)->GetFunction());
     }
 
-    v8::Local<v8::Value> factoryArgv[] = { Nan::New(proxyFunction), Nan::New<v8::External>((void*)wrap) };
-    v8::Local<v8::Function> funcProxy = 
-        (Nan::Call(Nan::New(proxyFactory), Nan::GetCurrentContext()->Global(), 2, factoryArgv)).ToLocalChecked().As<v8::Function>();
+    // The proxy calls clrFuncProxy directly with the wrap in its data, dispose looks the wrap up by a private property
+    v8::Local<v8::External> correlator = Nan::New<v8::External>((void*)wrap);
+    v8::Local<v8::Function> funcProxy = Nan::New<v8::Function>(clrFuncProxy, correlator);
+    Nan::SetPrivate(funcProxy, Nan::New<v8::String>("edge::clrFunc").ToLocalChecked(), correlator);
+    Nan::Set(funcProxy, Nan::New<v8::String>("dispose").ToLocalChecked(), Nan::New(proxyDisposeFunction));
     Nan::Persistent<v8::Function> funcProxyPersistent(funcProxy);
     funcProxyPersistent.SetWeak((void*)wrap, &clrFuncProxyNearDeath, Nan::WeakCallbackType::kParameter);
 
@@ -72,6 +154,9 @@ NAN_METHOD(ClrFunc::Initialize)
     Nan::EscapableHandleScope scope;
     v8::Local<v8::Object> options = info[0]->ToObject();
     v8::Local<v8::Function> result;
+    bool offload = options->Get(Nan::New<v8::String>("offload").ToLocalChecked())->IsTrue();
+    bool promise = options->Get(Nan::New<v8::String>("promise").ToLocalChecked())->IsTrue();
+    BufferMarshalMode bufferMode = GetBufferMarshalMode(options);
 
     v8::Local<v8::Value> jsassemblyFile = options->Get(Nan::New<v8::String>("assemblyFile").ToLocalChecked());
     if (jsassemblyFile->IsString())
@@ -85,7 +170,7 @@ NAN_METHOD(ClrFunc::Initialize)
         if (exc) {
             return Nan::ThrowError(ClrFunc::MarshalCLRExceptionToV8(exc));
         }
-        result = ClrFunc::Initialize(func);
+        result = ClrFunc::Initialize(func, offload, promise, bufferMode);
     }
     else
     {
@@ -110,7 +195,10 @@ NAN_METHOD(ClrFunc::Initialize)
         {
             // exception
         }
-        MonoObject* parameters = ClrFunc::MarshalV8ToCLR(options);
+        MonoObject* parameters = ClrFunc::MarshalV8ToCLR(options, &exc);
+        if (exc) {
+            return Nan::ThrowError(ClrFunc::MarshalCLRExceptionToV8(exc));
+        }
         MonoArray* methodInfoParams = mono_array_new(mono_domain_get(), mono_get_object_class(), 1);
         mono_array_setref(methodInfoParams, 0, parameters);
         void* params[2];
@@ -121,7 +209,7 @@ NAN_METHOD(ClrFunc::Initialize)
             return Nan::ThrowError(ClrFunc::MarshalCLRExceptionToV8(exc));
         }
 
-        result = ClrFunc::Initialize(func);
+        result = ClrFunc::Initialize(func, offload, promise, bufferMode);
     }
 
     info.GetReturnValue().Set(result);
@@ -172,11 +260,23 @@ v8::Local<v8::Value> ClrFunc::MarshalCLRToV8(MonoObject* netdata, MonoException*
 
     MonoClass* klass = mono_object_get_class(netdata);
     MonoString* primitive = NULL;
+    TypedArrayType arrayType = TypedArrayTypeNone;
 
 // printf("CLR->V8 class: %s\n", mono_class_get_name(klass));
     if (klass == mono_get_string_class())
     {
-        jsdata = stringCLR2V8((MonoString*)netdata);
+        MonoString* str = (MonoString*)netdata;
+        int length = mono_string_length(str);
+        if (minExternalStringLength > 0 && length >= minExternalStringLength)
+        {
+            // Large strings are not copied, the pin is released when the external string is collected
+            GCHandle pinnedHandle = mono_gchandle_new(netdata, TRUE);
+            jsdata = NewExternalString(mono_string_chars(str), length, ClrFunc::ReleasePinnedBuffer, (void*)(intptr_t)pinnedHandle);
+        }
+        else
+        {
+            jsdata = stringCLR2V8(str);
+        }
     }
     else if (klass == mono_get_char_class())
     {
@@ -256,7 +356,14 @@ v8::Local<v8::Value> ClrFunc::MarshalCLRToV8(MonoObject* netdata, MonoException*
     {
         MonoArray* buffer = (MonoArray*)netdata;
         size_t length = mono_array_length(buffer);      
-        if (length > 0)
+        if (enablePinnedByteArrays && length >= EDGE_MIN_PINNED_BUFFER_LENGTH)
+        {
+            // Large arrays are not copied, the pin is released when the node.js Buffer is collected
+            GCHandle pinnedHandle = mono_gchandle_new(netdata, TRUE);
+            uint8_t* pinnedBuffer = mono_array_addr(buffer, uint8_t, 0);
+            jsdata = NewExternalBuffer((char *)pinnedBuffer, length, ClrFunc::ReleasePinnedBuffer, (void*)(intptr_t)pinnedHandle);
+        }
+        else if (length > 0)
         {
             uint8_t* pinnedBuffer = mono_array_addr(buffer, uint8_t, 0);
             jsdata = Nan::CopyBuffer((char *)pinnedBuffer, length).ToLocalChecked();
@@ -266,6 +373,13 @@ v8::Local<v8::Value> ClrFunc::MarshalCLRToV8(MonoObject* netdata, MonoException*
             jsdata = Nan::NewBuffer(0).ToLocalChecked();
         }
     }
+    else if (enableMarshalArrayAsTypedArray && mono_class_get_rank(klass) == 1
+        && (arrayType = GetTypedArrayType(mono_class_get_element_class(klass))) != TypedArrayTypeNone)
+    {
+        MonoArray* netarray = (MonoArray*)netdata;
+        size_t length = mono_array_length(netarray);
+        jsdata = NewTypedArray(arrayType, mono_array_addr_with_size(netarray, GetTypedArrayElementSize(arrayType), 0), length);
+    }
     else if (mono_class_is_assignable_from (idictionary_string_object_class, klass)
              || mono_class_is_assignable_from (idictionary_class, klass))
     {
@@ -445,7 +559,7 @@ v8::Local<v8::Object> ClrFunc::MarshalCLRObjectToV8(MonoObject* netdata, MonoExc
     return scope.Escape(result);
 }
 
-MonoObject* ClrFunc::MarshalV8ToCLR(v8::Local<v8::Value> jsdata)
+MonoObject* ClrFunc::MarshalV8ToCLR(v8::Local<v8::Value> jsdata, MonoException** exc, BufferMarshalMode bufferMode)
 {
     DBG("ClrFunc::MarshalV8ToCLR");
     Nan::HandleScope scope;
@@ -457,9 +571,46 @@ MonoObject* ClrFunc::MarshalV8ToCLR(v8::Local<v8::Value> jsdata)
 
         return netfunc;
     }
+    // Every ArrayBufferView passes node::Buffer::HasInstance, so typed arrays are picked out first.
+    // Uint8Arrays, Buffers among them, keep marshaling as byte[] or Stream according to the buffer mode.
+    else if (GetTypedArrayType(jsdata) != TypedArrayTypeNone && !jsdata->IsUint8Array())
+    {
+        v8::Local<v8::TypedArray> jsarray = v8::Local<v8::TypedArray>::Cast(jsdata);
+        TypedArrayType arrayType = GetTypedArrayType(jsdata);
+        MonoArray* netarray = mono_array_new(mono_domain_get(), GetTypedArrayElementClass(arrayType), jsarray->Length());
+        jsarray->CopyContents(mono_array_addr_with_size(netarray, GetTypedArrayElementSize(arrayType), 0), jsarray->ByteLength());
+
+        return (MonoObject*)netarray;
+    }
     else if (node::Buffer::HasInstance(jsdata))
     {
         v8::Local<v8::Object> jsbuffer = jsdata->ToObject();
+
+        if (bufferMode != BufferMarshalModeCopy)
+        {
+            MonoObject* netstream;
+            int length = (int)node::Buffer::Length(jsbuffer);
+
+            if (bufferMode == BufferMarshalModeTransfer)
+            {
+                void* releaseContext;
+                char* data = DetachBufferData(jsbuffer, &releaseContext);
+                netstream = MonoEmbedding::CreateNativeBufferStream(data, length, FreeDetachedBufferData, releaseContext, exc);
+
+                if (*exc)
+                {
+                    // The stream was not created, so the detached data is still ours to free
+                    FreeDetachedBufferData(releaseContext);
+                }
+            }
+            else
+            {
+                netstream = MonoEmbedding::CreateNativeBufferStream(node::Buffer::Data(jsbuffer), length, NULL, NULL, exc);
+            }
+
+            return *exc ? NULL : netstream;
+        }
+
         MonoArray* netbuffer = mono_array_new(mono_domain_get(), mono_get_byte_class(), (int)node::Buffer::Length(jsbuffer));
         memcpy(mono_array_addr_with_size(netbuffer, sizeof(char), 0), node::Buffer::Data(jsbuffer), mono_array_length(netbuffer));
 
@@ -471,7 +622,13 @@ MonoObject* ClrFunc::MarshalV8ToCLR(v8::Local<v8::Value> jsdata)
         MonoArray* netarray = mono_array_new(mono_domain_get(), mono_get_object_class(), jsarray->Length());
         for (unsigned int i = 0; i < jsarray->Length(); i++)
         {
-            mono_array_setref(netarray, i, ClrFunc::MarshalV8ToCLR(jsarray->Get(i)));
+            MonoObject* netelement = ClrFunc::MarshalV8ToCLR(jsarray->Get(i), exc, bufferMode);
+            if (*exc)
+            {
+                return NULL;
+            }
+
+            mono_array_setref(netarray, i, netelement);
         }
 
         return (MonoObject*)netarray;
@@ -486,12 +643,17 @@ MonoObject* ClrFunc::MarshalV8ToCLR(v8::Local<v8::Value> jsdata)
     {
         MonoObject* netobject = MonoEmbedding::CreateExpandoObject();
         v8::Local<v8::Object> jsobject = v8::Local<v8::Object>::Cast(jsdata);
-        v8::Local<v8::Array> propertyNames = jsobject->GetPropertyNames();
+        v8::Local<v8::Array> propertyNames = Nan::GetOwnPropertyNames(jsobject).ToLocalChecked();
         for (unsigned int i = 0; i < propertyNames->Length(); i++)
         {
-            v8::Local<v8::String> name = v8::Local<v8::String>::Cast(propertyNames->Get(i));
-            v8::String::Utf8Value utf8name(name);
-            Dictionary::Add(netobject, *utf8name, ClrFunc::MarshalV8ToCLR(jsobject->Get(name)));
+            v8::Local<v8::String> name = Nan::To<v8::String>(propertyNames->Get(i)).ToLocalChecked();
+            MonoObject* netvalue = ClrFunc::MarshalV8ToCLR(jsobject->Get(name), exc, bufferMode);
+            if (*exc)
+            {
+                return NULL;
+            }
+
+            Dictionary::Add(netobject, ClrFunc::GetPropertyName(name), netvalue);
         }
 
         return netobject;
@@ -531,37 +693,130 @@ MonoObject* ClrFunc::MarshalV8ToCLR(v8::Local<v8::Value> jsdata)
     }
 }
 
+// Property names seen repeatedly in JavaScript objects, bucketed by their hash, so names of repeated
+// payload shapes map to the same interned CLR string without being converted again
+typedef std::unordered_multimap<int, ClrPropertyName*> ClrPropertyNameMap;
+static ClrPropertyNameMap propertyNames;
+
+MonoString* ClrFunc::GetPropertyName(v8::Local<v8::String> name)
+{
+    int hash = name->GetIdentityHash();
+    std::pair<ClrPropertyNameMap::iterator, ClrPropertyNameMap::iterator> bucket = propertyNames.equal_range(hash);
+    ClrPropertyName* propertyName = NULL;
+
+    for (ClrPropertyNameMap::iterator cachedName = bucket.first; cachedName != bucket.second; cachedName++)
+    {
+        if (Nan::New(cachedName->second->name)->StrictEquals(name))
+        {
+            propertyName = cachedName->second;
+            break;
+        }
+    }
+
+    if (!propertyName && propertyNames.size() < EDGE_MAX_CACHED_PROPERTY_NAMES && IsRepeatedPropertyName(hash))
+    {
+        propertyName = new ClrPropertyName();
+        propertyName->name.Reset(name);
+        propertyName->clrName = mono_gchandle_new((MonoObject*)mono_string_intern(stringV82CLR(name)), FALSE);
+        propertyNames.insert(std::make_pair(hash, propertyName));
+    }
+
+    // Names seen for the first time or that do not fit in the cache are converted every time
+    if (propertyName)
+    {
+        return (MonoString*)mono_gchandle_get_target(propertyName->clrName);
+    }
+
+    return stringV82CLR(name);
+}
+
+void __cdecl ClrFunc::ReleasePinnedBuffer(void* context)
+{
+    DBG("ClrFunc::ReleasePinnedBuffer");
+    mono_gchandle_free((GCHandle)(intptr_t)context);
+}
+
+// Errors of calls returning a promise reject the promise instead of being thrown
+static v8::Local<v8::Value> ThrowOrReject(v8::Local<v8::Promise::Resolver> resolver, v8::Local<v8::Value> error)
+{
+    if (resolver.IsEmpty())
+    {
+        Nan::ThrowError(error);
+        return Nan::Undefined();
+    }
+
+    resolver->Reject(Nan::GetCurrentContext(), error).FromJust();
+    return resolver->GetPromise();
+}
+
 v8::Local<v8::Value> ClrFunc::Call(v8::Local<v8::Value> payload, v8::Local<v8::Value> callback)
 {
     DBG("ClrFunc::Call instance");
     Nan::EscapableHandleScope scope;
     MonoException* exc = NULL;
+    v8::Local<v8::Promise::Resolver> resolver;
+    ClrFuncInvokeContext* c;
 
-    ClrFuncInvokeContext* c = new ClrFuncInvokeContext(callback);
-    c->Payload(ClrFunc::MarshalV8ToCLR(payload));
+    if (this->promise && callback->IsUndefined())
+    {
+        // Calls without a callback complete a promise created for them, it is returned once the call is started
+        resolver = v8::Promise::Resolver::New(Nan::GetCurrentContext()).ToLocalChecked();
+        c = ClrFuncInvokeContext::Acquire(resolver);
+    }
+    else
+    {
+        c = ClrFuncInvokeContext::Acquire(callback);
+    }
+
+    c->Payload(ClrFunc::MarshalV8ToCLR(payload, &exc, this->bufferMode));
+    if (exc)
+    {
+        ClrFuncInvokeContext::Release(c);
+        c = NULL;
+        return scope.Escape(ThrowOrReject(resolver, ClrFunc::MarshalCLRExceptionToV8(exc)));
+    }
+
+    if (this->bufferMode == BufferMarshalModeView)
+    {
+        c->KeepAlive(payload);
+    }
 
     MonoObject* func = mono_gchandle_get_target(this->func);
-    void* params[1];
-    params[0] = c->Payload();
-    MonoMethod* invoke = mono_class_get_method_from_name(mono_object_get_class(func), "Invoke", -1);
-    // This is different from dotnet. From the documentation http://www.mono-project.com/Embedding_Mono: 
-    MonoObject* task = mono_runtime_invoke(invoke, func, params, (MonoObject**)&exc);
+    MonoObject* task;
+    if (this->offload && !c->Sync())
+    {
+        // The payload has been marshaled on V8 thread, the function itself runs on the CLR thread pool
+        task = MonoEmbedding::RunFuncOnThreadPool(func, c->Payload(), &exc);
+    }
+    else
+    {
+        static MonoClass* funcClass;
+        static MonoMethod* invoke;
+        void* params[1];
+        params[0] = c->Payload();
+        if (funcClass != mono_object_get_class(func))
+        {
+            funcClass = mono_object_get_class(func);
+            invoke = mono_class_get_method_from_name(funcClass, "Invoke", -1);
+        }
+        // This is different from dotnet. From the documentation http://www.mono-project.com/Embedding_Mono: 
+        task = mono_runtime_invoke(invoke, func, params, (MonoObject**)&exc);
+    }
+
     if (exc)
     {
-        delete c;
+        ClrFuncInvokeContext::Release(c);
         c = NULL;
-        Nan::ThrowError(ClrFunc::MarshalCLRExceptionToV8(exc));
-        return scope.Escape(Nan::Undefined());
+        return scope.Escape(ThrowOrReject(resolver, ClrFunc::MarshalCLRExceptionToV8(exc)));
     }
 
     MonoProperty* prop = mono_class_get_property_from_name(mono_object_get_class(task), "IsCompleted");
     MonoObject* isCompletedObject = mono_property_get_value(prop, task, NULL, (MonoObject**)&exc);
     if (exc)
     {
-        delete c;
+        ClrFuncInvokeContext::Release(c);
         c = NULL;
-        Nan::ThrowError(ClrFunc::MarshalCLRExceptionToV8(exc));
-        return scope.Escape(Nan::Undefined());
+        return scope.Escape(ThrowOrReject(resolver, ClrFunc::MarshalCLRExceptionToV8(exc)));
     }
 
     bool isCompleted = *(bool*)mono_object_unbox(isCompletedObject);
@@ -569,10 +824,18 @@ v8::Local<v8::Value> ClrFunc::Call(v8::Local<v8::Value> payload, v8::Local<v8::V
     {
         // Completed synchronously. Return a value or invoke callback based on call pattern.
         c->Task(task);
-        return scope.Escape(c->CompleteOnV8Thread(true));
+        v8::Local<v8::Value> result = c->CompleteOnV8Thread(true);
+        if (!resolver.IsEmpty())
+        {
+            return scope.Escape(resolver->GetPromise());
+        }
+
+        return scope.Escape(result);
     }
     else if (c->Sync())
     {
+        ClrFuncInvokeContext::Release(c);
+        c = NULL;
         Nan::ThrowError(ClrFunc::MarshalCLRExceptionToV8(mono_get_exception_invalid_operation("The JavaScript function was called synchronously "
             "but the underlying CLR function returned without completing the Task. Call the "
             "JavaScript function asynchronously.")));
@@ -585,12 +848,16 @@ v8::Local<v8::Value> ClrFunc::Call(v8::Local<v8::Value> payload, v8::Local<v8::V
         MonoEmbedding::ContinueTask(task, c->GetMonoObject(), &exc);
         if (exc)
         {
-            delete c;
+            ClrFuncInvokeContext::Release(c);
             c = NULL;
-            Nan::ThrowError(ClrFunc::MarshalCLRExceptionToV8(exc));
-            return scope.Escape(Nan::Undefined());
+            return scope.Escape(ThrowOrReject(resolver, ClrFunc::MarshalCLRExceptionToV8(exc)));
         }
     }
 
+    if (!resolver.IsEmpty())
+    {
+        return scope.Escape(resolver->GetPromise());
+    }
+
     return scope.Escape(Nan::Undefined());
 }
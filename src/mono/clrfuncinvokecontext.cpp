@@ -10,15 +10,14 @@ static MonoClass* GetClrFuncInvokeContextClass()
     return klass;
 }
 
-ClrFuncInvokeContext::ClrFuncInvokeContext(v8::Local<v8::Value> callbackOrSync) : _this(0), callback(0), uv_edge_async(0)
+static std::vector<ClrFuncInvokeContext*> freeInvokeContexts;
+
+ClrFuncInvokeContext::ClrFuncInvokeContext() : _this(0), uv_edge_async(0)
 {
     static MonoClassField* field;
-    static MonoClassField* syncField;
 
     if (!field)
         field = mono_class_get_field_from_name(GetClrFuncInvokeContextClass(), "native");
-    if (!syncField)
-        syncField = mono_class_get_field_from_name(GetClrFuncInvokeContextClass(), "Sync");
 
     MonoObject* obj = mono_object_new(mono_domain_get(), GetClrFuncInvokeContextClass());
 
@@ -27,47 +26,89 @@ ClrFuncInvokeContext::ClrFuncInvokeContext(v8::Local<v8::Value> callbackOrSync)
     this->_this = mono_gchandle_new(obj, FALSE); // released in destructor
 
     DBG("ClrFuncInvokeContext::ClrFuncInvokeContext");
+}
+
+ClrFuncInvokeContext* ClrFuncInvokeContext::Acquire(v8::Local<v8::Value> callbackOrSync)
+{
+    DBG("ClrFuncInvokeContext::Acquire");
+
+    ClrFuncInvokeContext* context;
+
+    if (freeInvokeContexts.empty())
+    {
+        context = new ClrFuncInvokeContext();
+    }
+    else
+    {
+        context = freeInvokeContexts.back();
+        freeInvokeContexts.pop_back();
+    }
+
     if (callbackOrSync->IsFunction())
     {
-        // released in destructor
-        this->callback = new Nan::Callback(v8::Local<v8::Function>::Cast(callbackOrSync));
-        this->Sync(FALSE);
+        // released in Release
+        context->callback.Reset(v8::Local<v8::Function>::Cast(callbackOrSync));
+        context->Sync(FALSE);
     }
     else 
     {
-        this->Sync(callbackOrSync->BooleanValue());
+        context->Sync(callbackOrSync->BooleanValue());
+    }
+
+    return context;
+}
+
+ClrFuncInvokeContext* ClrFuncInvokeContext::Acquire(v8::Local<v8::Promise::Resolver> resolver)
+{
+    // released in Release
+    ClrFuncInvokeContext* context = Acquire(v8::Local<v8::Value>(Nan::Undefined()));
+    context->resolver.Reset(resolver);
+
+    return context;
+}
+
+void ClrFuncInvokeContext::Release(ClrFuncInvokeContext* context)
+{
+    DBG("ClrFuncInvokeContext::Release");
+
+    context->callback.Reset();
+    context->resolver.Reset();
+    context->jsPayload.Reset();
+    context->uv_edge_async = NULL;
+
+    // The managed context must not keep the payload and task of the completed call alive
+    context->Payload(NULL);
+    context->Task(NULL);
+
+    if (freeInvokeContexts.size() < EDGE_MAX_POOLED_INVOKE_CONTEXTS)
+    {
+        freeInvokeContexts.push_back(context);
+    }
+    else
+    {
+        delete context;
     }
 }
 
 void ClrFuncInvokeContext::InitializeAsyncOperation()
 {
     // Create a uv_edge_async instance representing V8 async operation that will complete 
-    // when the CLR function completes. The ClrActionContext is used to ensure the ClrFuncInvokeContext
-    // remains GC-rooted while the CLR function executes.
-
-    static MonoMethod* getAction = NULL;
-    if (!getAction)
-        getAction = mono_class_get_method_from_name(
-            GetClrFuncInvokeContextClass(), "GetCompleteOnV8ThreadAsynchronousAction", -1);
-    
-    ClrActionContext* data = new ClrActionContext;
-    data->action = mono_gchandle_new( // released in ClrActionContext::ActionCallback
-        mono_runtime_invoke(getAction, mono_gchandle_get_target(this->_this), NULL, NULL), FALSE);
-    this->uv_edge_async = V8SynchronizationContext::RegisterAction(ClrActionContext::ActionCallback, data);
+    // when the CLR function completes. The managed ClrFuncInvokeContext remains GC-rooted
+    // through _this while the CLR function executes.
+    this->uv_edge_async = V8SynchronizationContext::RegisterAction(ClrFuncInvokeContext::CompleteOnV8ThreadAsynchronous, this);
 }
 
 ClrFuncInvokeContext::~ClrFuncInvokeContext()
 {
-    if (this->callback)
-    {
-        DBG("ClrFuncInvokeContext::DisposeCallback");
-        this->callback->Reset();
-        delete this->callback;
-        this->callback = NULL;        
-    }
     mono_gchandle_free(this->_this);
 }
 
+void ClrFuncInvokeContext::KeepAlive(v8::Local<v8::Value> payload)
+{
+    // Buffers passed to the CLR as views must not be collected before the call completes
+    this->jsPayload.Reset(payload);
+}
+
 void ClrFuncInvokeContext::CompleteOnCLRThread(ClrFuncInvokeContext *_this, MonoObject* task)
 {
     DBG("ClrFuncInvokeContext::CompleteOnCLRThread");
@@ -75,10 +116,10 @@ void ClrFuncInvokeContext::CompleteOnCLRThread(ClrFuncInvokeContext *_this, Mono
     V8SynchronizationContext::ExecuteAction(_this->uv_edge_async);
 }
 
-void ClrFuncInvokeContext::CompleteOnV8ThreadAsynchronous(ClrFuncInvokeContext *_this)
+void ClrFuncInvokeContext::CompleteOnV8ThreadAsynchronous(void* data)
 {
     Nan::HandleScope scope;
-    _this->CompleteOnV8Thread(false);
+    ((ClrFuncInvokeContext*)data)->CompleteOnV8Thread(false);
 }
 
 v8::Local<v8::Value> ClrFuncInvokeContext::CompleteOnV8Thread(bool completedSynchronously)
@@ -90,10 +131,10 @@ v8::Local<v8::Value> ClrFuncInvokeContext::CompleteOnV8Thread(bool completedSync
     // The uv_edge_async was already cleaned up in V8SynchronizationContext::ExecuteAction
     this->uv_edge_async = NULL;
 
-    if (!this->Sync() && !this->callback)
+    if (!this->Sync() && this->callback.IsEmpty() && this->resolver.IsEmpty())
     {
         // this was an async call without callback specified
-        delete this;
+        Release(this);
         return scope.Escape(Nan::Undefined());
     }
 
@@ -127,13 +168,36 @@ v8::Local<v8::Value> ClrFuncInvokeContext::CompleteOnV8Thread(bool completedSync
         break;
     };
 
-    if (!this->Sync())
+    if (!this->resolver.IsEmpty())
+    {
+        // complete the asynchronous call to C# by settling the promise returned from the call
+        DBG("ClrFuncInvokeContext::CompleteOnV8Thread - completing promise");
+        v8::Local<v8::Promise::Resolver> resolver = Nan::New(this->resolver);
+        Release(this);
+
+        if (1 == argc)
+        {
+            resolver->Reject(Nan::GetCurrentContext(), argv[0]).FromJust();
+        }
+        else
+        {
+            resolver->Resolve(Nan::GetCurrentContext(), argv[1]).FromJust();
+        }
+
+        if (!completedSynchronously)
+        {
+            CallbackHelper::KickNextTick();
+        }
+
+        return scope.Escape(Nan::Undefined());
+    }
+    else if (!this->Sync())
     {
         // complete the asynchronous call to C# by invoking a callback in JavaScript
         Nan::TryCatch try_catch;
         DBG("ClrFuncInvokeContext::CompleteOnV8Thread - calling JS callback");
-        this->callback->Call(argc, argv);
-        delete this;
+        this->callback.Call(argc, argv);
+        Release(this);
         if (try_catch.HasCaught())
         {
             DBG("ClrFuncInvokeContext::CompleteOnV8Thread - exception in callback");
@@ -143,7 +207,7 @@ v8::Local<v8::Value> ClrFuncInvokeContext::CompleteOnV8Thread(bool completedSync
         return scope.Escape(Nan::Undefined());
     }
     else {
-        delete this;
+        Release(this);
         if (1 == argc) 
         {
             // complete the synchronous call to C# by re-throwing the resulting exception
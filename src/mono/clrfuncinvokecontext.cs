@@ -20,17 +20,4 @@ class ClrFuncInvokeContext
     {
         CompleteOnCLRThreadICall(native, task);
     }
-
-    [MethodImplAttribute(MethodImplOptions.InternalCall)]
-    static extern void CompleteOnV8ThreadAsynchronousICall(IntPtr ptr);
-
-    void CompleteOnV8ThreadAsynchronous()
-    {
-        CompleteOnV8ThreadAsynchronousICall(native);
-    }
-
-    public Action GetCompleteOnV8ThreadAsynchronousAction()
-    {
-        return new Action(CompleteOnV8ThreadAsynchronous);
-    }
 };
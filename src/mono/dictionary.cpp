@@ -1,6 +1,6 @@
 #include "edge.h"
 
-void Dictionary::Add(MonoObject* _this, const char* name, MonoObject* value)
+void Dictionary::Add(MonoObject* _this, MonoString* name, MonoObject* value)
 {
     static MonoMethod* add;
     
@@ -10,7 +10,7 @@ void Dictionary::Add(MonoObject* _this, const char* name, MonoObject* value)
     }
 
     void* params[2];
-    params[0] = mono_string_new(mono_domain_get(), name);
+    params[0] = name;
     params[1] = value;
 
     mono_runtime_invoke(add, _this, params, NULL);
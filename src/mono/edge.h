@@ -4,6 +4,8 @@
 #include "../common/edge_common.h"
 
 #include <pthread.h>
+#include <unordered_map>
+#include <vector>
 #include "mono/metadata/class.h"
 #include "mono/metadata/object.h"
 #include "mono/metadata/appdomain.h"
@@ -32,6 +34,8 @@ public:
     static MonoArray* IEnumerableToArray(MonoObject* ienumerable, MonoException** exc);
     static MonoArray* IDictionaryToFlatArray(MonoObject* dictionary, MonoException** exc);
     static void ContinueTask(MonoObject* task, MonoObject* state, MonoException** exc);
+    static MonoObject* RunFuncOnThreadPool(MonoObject* func, MonoObject* payload, MonoException** exc);
+    static MonoObject* CreateNativeBufferStream(char* buffer, int length, ReleaseBufferFunction release, void* releaseContext, MonoException** exc);
     static double GetDateValue(MonoObject* dt, MonoException** exc);
     static MonoString* ToString(MonoObject* o, MonoException** exc);
     static double Int64ToDouble(MonoObject* i64, MonoException** exc);
@@ -58,14 +62,28 @@ public:
 class Dictionary
 {
 public: 
-    static void Add(MonoObject* _this, const char* name, MonoObject* value);
+    static void Add(MonoObject* _this, MonoString* name, MonoObject* value);
 };
 
+// Property name of JavaScript objects passed to the CLR and the interned CLR string cached for it
+typedef struct clrPropertyName
+{
+    Nan::Persistent<v8::String> name;
+    GCHandle clrName;
+} ClrPropertyName;
+
+// Invoke contexts and their managed counterparts are acquired and released on the V8 thread,
+// released contexts are pooled for later calls
 class ClrFuncInvokeContext {
 private:
     GCHandle _this;
-    Nan::Callback* callback;
+    Nan::Callback callback;
+    Nan::Persistent<v8::Promise::Resolver> resolver;
     uv_edge_async_t* uv_edge_async;
+    Nan::Persistent<v8::Value> jsPayload;
+
+    ClrFuncInvokeContext();
+    ~ClrFuncInvokeContext();
 
 public:
     MonoObject* Payload();
@@ -77,18 +95,21 @@ public:
 
     MonoObject* GetMonoObject();
 
-    ClrFuncInvokeContext(v8::Local<v8::Value> callbackOrSync);
-    ~ClrFuncInvokeContext();
+    static ClrFuncInvokeContext* Acquire(v8::Local<v8::Value> callbackOrSync);
+    static ClrFuncInvokeContext* Acquire(v8::Local<v8::Promise::Resolver> resolver);
+    static void Release(ClrFuncInvokeContext* context);
 
     void InitializeAsyncOperation();
+    void KeepAlive(v8::Local<v8::Value> payload);
 
     static void __cdecl CompleteOnCLRThread(ClrFuncInvokeContext *_this, MonoObject* task);
-    static void __cdecl CompleteOnV8ThreadAsynchronous(ClrFuncInvokeContext *_this);
+    static void CompleteOnV8ThreadAsynchronous(void* data);
     v8::Local<v8::Value> CompleteOnV8Thread(bool completedSynchronously);
 };
 
 class NodejsFunc {
     GCHandle _this;
+    static int liveCount;
 public:
     Nan::Persistent<v8::Function>* Func;
 
@@ -99,15 +120,24 @@ public:
 
     static void __cdecl ExecuteActionOnV8Thread(MonoObject* action);
     static void __cdecl Release(NodejsFunc* _this);
+    static int GetLiveCount();
+
+    // Set while ExecuteActionOnV8Thread runs an action inline on V8 thread
+    static bool runningActionInline;
 };
 
 class NodejsFuncInvokeContext {
     GCHandle _this;
+
+    // Call being made inline on V8 thread, it completes synchronously if it completes before returning
+    static NodejsFuncInvokeContext* inlineContext;
+
 public:
     NodejsFuncInvokeContext(MonoObject* _this);
     ~NodejsFuncInvokeContext();
 
     static void __cdecl CallFuncOnV8Thread(MonoObject* _this, NodejsFunc* nativeNodejsFunc, MonoObject* payload);
+    static void CompleteCallback(void* data, bool faulted, v8::Local<v8::Value> value);
     void Complete(MonoObject* exception, MonoObject* result);
 };
 
@@ -115,18 +145,30 @@ class ClrFunc {
 private:
     //System::Func<System::Object^,Task<System::Object^>^>^ func;
     GCHandle func;
+    bool offload;
+    bool promise;
+    BufferMarshalMode bufferMode;
+    int references;
+
+    static int liveCount;
 
     ClrFunc();
+    ~ClrFunc();
 
     static v8::Local<v8::Object> MarshalCLRObjectToV8(MonoObject* netdata, MonoException** exc);
+    static void __cdecl ReleasePinnedBuffer(void* context);
+    static MonoString* GetPropertyName(v8::Local<v8::String> name);
 
 public:
     static NAN_METHOD(Initialize);
-    static v8::Local<v8::Function> Initialize(MonoObject* func);
+    static int GetLiveCount();
+    void AddRef();
+    static void Release(ClrFunc* function);
+    static v8::Local<v8::Function> Initialize(MonoObject* func, bool offload = false, bool promise = false, BufferMarshalMode bufferMode = BufferMarshalModeCopy);
     v8::Local<v8::Value> Call(v8::Local<v8::Value> payload, v8::Local<v8::Value> callback);
     static v8::Local<v8::Value> MarshalCLRToV8(MonoObject* netdata, MonoException** exc);
     static v8::Local<v8::Value> MarshalCLRExceptionToV8(MonoException* exception);
-    static MonoObject* MarshalV8ToCLR(v8::Local<v8::Value> jsdata);    
+    static MonoObject* MarshalV8ToCLR(v8::Local<v8::Value> jsdata, MonoException** exc, BufferMarshalMode bufferMode = BufferMarshalModeCopy);    
 };
 
 typedef struct clrFuncWrap {
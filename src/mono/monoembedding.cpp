@@ -30,7 +30,6 @@ void MonoEmbedding::Initialize()
     MonoArray* args = mono_array_new(mono_domain_get(), mono_get_string_class(), 0);
     mono_runtime_exec_main(main, args, (MonoObject**)&exc);
 
-    mono_add_internal_call("ClrFuncInvokeContext::CompleteOnV8ThreadAsynchronousICall", (const void*)&ClrFuncInvokeContext::CompleteOnV8ThreadAsynchronous); 
     mono_add_internal_call("ClrFuncInvokeContext::CompleteOnCLRThreadICall", (const void*)&ClrFuncInvokeContext::CompleteOnCLRThread); 
     mono_add_internal_call("NodejsFuncInvokeContext::CallFuncOnV8ThreadInternal", (const void*)&NodejsFuncInvokeContext::CallFuncOnV8Thread); 
     mono_add_internal_call("NodejsFunc::ExecuteActionOnV8Thread", (const void*)&NodejsFunc::ExecuteActionOnV8Thread); 
@@ -221,6 +220,36 @@ void MonoEmbedding::ContinueTask(MonoObject* task, MonoObject* state, MonoExcept
     mono_runtime_invoke(method, NULL, args, (MonoObject**)exc);
 }
 
+MonoObject* MonoEmbedding::RunFuncOnThreadPool(MonoObject* func, MonoObject* payload, MonoException** exc)
+{
+    static MonoMethod* method;
+    *exc = NULL;
+
+    if (!method)
+        method = mono_class_get_method_from_name(MonoEmbedding::GetClass(), "RunFuncOnThreadPool", -1);
+
+    void* args[2];
+    args[0] = func;
+    args[1] = payload;
+    return mono_runtime_invoke(method, NULL, args, (MonoObject**)exc);
+}
+
+MonoObject* MonoEmbedding::CreateNativeBufferStream(char* buffer, int length, ReleaseBufferFunction release, void* releaseContext, MonoException** exc)
+{
+    static MonoMethod* method;
+    *exc = NULL;
+
+    if (!method)
+        method = mono_class_get_method_from_name(MonoEmbedding::GetClass(), "CreateNativeBufferStream", -1);
+
+    void* args[4];
+    args[0] = &buffer;
+    args[1] = &length;
+    args[2] = &release;
+    args[3] = &releaseContext;
+    return mono_runtime_invoke(method, NULL, args, (MonoObject**)exc);
+}
+
 double MonoEmbedding::GetDateValue(MonoObject* dt, MonoException** exc)
 {
     static MonoMethod* method;
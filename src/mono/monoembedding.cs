@@ -119,6 +119,8 @@ public static class MonoEmbedding
         return typeof(Func<Object, Task<Object>>);
     }
 
+    static readonly Action<Task<object>, object> edgeAppCompletedOnCLRThreadAction = edgeAppCompletedOnCLRThread;
+
     static public void edgeAppCompletedOnCLRThread(Task<object> task, object state)
     {
         var context = (ClrFuncInvokeContext)state;
@@ -128,7 +130,18 @@ public static class MonoEmbedding
     static public void ContinueTask(Task<object> task, object state)
     {
         // Will complete asynchronously. Schedule continuation to finish processing.
-        task.ContinueWith(new Action<Task<object>, object>(edgeAppCompletedOnCLRThread), state);
+        task.ContinueWith(edgeAppCompletedOnCLRThreadAction, state);
+    }
+
+    static public Task<object> RunFuncOnThreadPool(Func<object, Task<object>> func, object payload)
+    {
+        // Keeps CPU bound work the function does before its first await off the V8 thread
+        return Task.Run(() => func(payload));
+    }
+
+    static public NativeBufferStream CreateNativeBufferStream(IntPtr buffer, int length, IntPtr release, IntPtr releaseContext)
+    {
+        return new NativeBufferStream(buffer, length, release, releaseContext);
     }
 
     static public string ObjectToString(object o)
@@ -10,6 +10,9 @@ static MonoClass* GetNodejsFuncClass()
     return klass;
 }
 
+int NodejsFunc::liveCount = 0;
+bool NodejsFunc::runningActionInline = false;
+
 NodejsFunc::NodejsFunc(v8::Local<v8::Function> function)
 {
     DBG("NodejsFunc::NodejsFunc");
@@ -27,6 +30,7 @@ NodejsFunc::NodejsFunc(v8::Local<v8::Function> function)
     void *args[] = { &thisPtr };
     mono_runtime_invoke(ctor, thisObj, args, (MonoObject**)&exc);
     _this = mono_gchandle_new_weakref(thisObj, FALSE);
+    liveCount++;
 }
 
 NodejsFunc::~NodejsFunc() 
@@ -35,6 +39,8 @@ NodejsFunc::~NodejsFunc()
     this->Func->Reset();
     delete this->Func;
     this->Func = NULL;
+    mono_gchandle_free(_this);
+    liveCount--;
 }
 
 void NodejsFunc::Release(NodejsFunc* _this)
@@ -42,6 +48,11 @@ void NodejsFunc::Release(NodejsFunc* _this)
     delete _this;
 }
 
+int NodejsFunc::GetLiveCount()
+{
+    return liveCount;
+}
+
 MonoObject* NodejsFunc::GetFunc()
 {
     static MonoMethod* method;
@@ -59,6 +70,18 @@ void  NodejsFunc::ExecuteActionOnV8Thread(MonoObject* action)
 {
     ClrActionContext* data = new ClrActionContext;
     data->action = mono_gchandle_new(action, FALSE); // released in ClrActionContext::ActionCallback
+
+    if (V8SynchronizationContext::IsOnV8Thread())
+    {
+        // CLR code running synchronously on V8 thread, e.g. a NodejsFunc called from within a CLR function
+        // invoked by JavaScript, has the action run right away rather than on a later turn of the event loop
+        Nan::HandleScope scope;
+        NodejsFunc::runningActionInline = true;
+        ClrActionContext::ActionCallback(data);
+        NodejsFunc::runningActionInline = false;
+        return;
+    }
+
     uv_edge_async_t* uv_edge_async = V8SynchronizationContext::RegisterAction(ClrActionContext::ActionCallback, data);
     V8SynchronizationContext::ExecuteAction(uv_edge_async);    
 }
@@ -1,24 +1,6 @@
 #include "edge.h"
 
-NAN_METHOD(v8FuncCallback)
-{
-    DBG("v8FuncCallback");
-    Nan::HandleScope scope;
-    v8::Local<v8::External> correlator = v8::Local<v8::External>::Cast(info[2]);
-    NodejsFuncInvokeContext* context = (NodejsFuncInvokeContext*)(correlator->Value());
-    if (!info[0]->IsUndefined() && !info[0]->IsNull())
-    {
-       context->Complete((MonoObject*)exceptionV82stringCLR(info[0]), NULL);
-    }
-    else 
-    {
-        // TODO add support for exceptions during marshaling:
-        MonoObject* result = ClrFunc::MarshalV8ToCLR(info[1]);
-        context->Complete(NULL, result);
-    }
-    info.GetReturnValue().SetUndefined();
-}
-
+NodejsFuncInvokeContext* NodejsFuncInvokeContext::inlineContext = NULL;
 
 NodejsFuncInvokeContext::NodejsFuncInvokeContext(MonoObject* _this) 
 {
@@ -36,11 +18,15 @@ void NodejsFuncInvokeContext::CallFuncOnV8Thread(MonoObject* _this, NodejsFunc*
 {
     DBG("NodejsFuncInvokeContext::CallFuncOnV8Thread");
 
-    static Nan::Persistent<v8::Function> callbackFactory;
-    static Nan::Persistent<v8::Function> callbackFunction;
-
     Nan::HandleScope scope;
     NodejsFuncInvokeContext* ctx = new NodejsFuncInvokeContext(_this);
+
+    // Only this call runs inline, JavaScript it calls may start calls of its own
+    bool inlineCall = NodejsFunc::runningActionInline;
+    NodejsFunc::runningActionInline = false;
+
+    NodejsFuncInvokeContext* previousInlineContext = inlineContext;
+    inlineContext = inlineCall ? ctx : NULL;
     
     MonoException* exc = NULL;
     v8::Local<v8::Value> jspayload = ClrFunc::MarshalCLRToV8(payload, &exc);
@@ -51,40 +37,41 @@ void NodejsFuncInvokeContext::CallFuncOnV8Thread(MonoObject* _this, NodejsFunc*
     }
     else 
     {
-        // See https://github.com/tjanczuk/edge/issues/125 for context
-        
-        if (callbackFactory.IsEmpty())
+        // Processing resumes in CompleteCallback once the function has called back or settled its result
+        NodejsFuncCompletion::Invoke(
+            Nan::New(*(nativeNodejsFunc->Func)), jspayload, ctx, NodejsFuncInvokeContext::CompleteCallback);
+
+        // Kick the next tick of calls queued from CLR threads, inline calls leave it to their JavaScript caller
+        if (!inlineCall)
         {
-            v8::Local<v8::Function> v8FuncCallbackFunction = Nan::New<v8::FunctionTemplate>(v8FuncCallback)->GetFunction();
-            callbackFunction.Reset(v8FuncCallbackFunction);
-            v8::Local<v8::String> code = Nan::New<v8::String>(
-                "(function (cb, ctx) { return function (e, d) { return cb(e, d, ctx); }; })").ToLocalChecked();
-            v8::Local<v8::Function> callbackFactoryFunction = v8::Local<v8::Function>::Cast(v8::Script::Compile(code)->Run());
-            callbackFactory.Reset(callbackFactoryFunction);
+            CallbackHelper::KickNextTick();
         }
+    }
+
+    inlineContext = previousInlineContext;
+}
 
-        v8::Local<v8::Value> factoryArgv[] = { Nan::New(callbackFunction), Nan::New<v8::External>((void*)ctx) };
-        v8::Local<v8::Function> callback = v8::Local<v8::Function>::Cast(
-            Nan::New(callbackFactory)->Call(Nan::GetCurrentContext()->Global(), 2, factoryArgv));
+void NodejsFuncInvokeContext::CompleteCallback(void* data, bool faulted, v8::Local<v8::Value> value)
+{
+    DBG("NodejsFuncInvokeContext::CompleteCallback");
 
-        v8::Local<v8::Value> argv[] = { jspayload, callback };
-        Nan::TryCatch tryCatch;
-        DBG("NodejsFuncInvokeContext::CallFuncOnV8Thread calling JavaScript function");
-        Nan::Call(Nan::New(*(nativeNodejsFunc->Func)), Nan::GetCurrentContext()->Global(), 2, argv);
-        DBG("NodejsFuncInvokeContext::CallFuncOnV8Thread called JavaScript function");
-        if (tryCatch.HasCaught()) 
+    NodejsFuncInvokeContext* ctx = (NodejsFuncInvokeContext*)data;
+    if (faulted)
+    {
+        ctx->Complete((MonoObject*)exceptionV82stringCLR(value), NULL);
+    }
+    else 
+    {
+        MonoException* exc = NULL;
+        MonoObject* result = ClrFunc::MarshalV8ToCLR(value, &exc);
+        if (exc)
         {
-            DBG("NodejsFuncInvokeContext::CallFuncOnV8Thread caught JavaScript exception");
-            ctx->Complete((MonoObject*)exceptionV82stringCLR(tryCatch.Exception()), NULL);
-            // ctx deleted in Complete
+            ctx->Complete((MonoObject*)exc, NULL);
         }
         else
         {
-            // Kick the next tick
-            CallbackHelper::KickNextTick();
+            ctx->Complete(NULL, result);
         }
-
-        // In the absence of exception, processing resumes in v8FuncCallback
     }
 }
 
@@ -97,10 +84,17 @@ void NodejsFuncInvokeContext::Complete(MonoObject* exception, MonoObject* result
     if (!method)
     {
         MonoClass* klass = mono_class_from_name(MonoEmbedding::GetImage(), "", "NodejsFuncInvokeContext");
-        method = mono_class_get_method_from_name(klass, "Complete", 2);
+        method = mono_class_get_method_from_name(klass, "Complete", 3);
+    }
+
+    // Only V8 thread reads and writes inlineContext, so completing on it needs no synchronization
+    MonoBoolean synchronous = this == inlineContext;
+    if (synchronous)
+    {
+        inlineContext = NULL;
     }
 
-    void* args[] = { exception, result };
+    void* args[] = { exception, result, &synchronous };
     mono_runtime_invoke(method, mono_gchandle_get_target(this->_this), args, NULL);
     delete this;
 }
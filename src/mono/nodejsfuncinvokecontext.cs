@@ -25,31 +25,42 @@ class NodejsFuncInvokeContext {
     [MethodImplAttribute(MethodImplOptions.InternalCall)]
     static extern void CallFuncOnV8ThreadInternal(NodejsFuncInvokeContext _this, IntPtr nativeNodejsFunc, object payload);        
 
-    public void Complete(object exception, object result)
+    public void Complete(object exception, object result, bool synchronous)
     {
-        Task.Run(() => {
-            if (exception != null)
+        if (synchronous)
+        {
+            // Completed inline on V8 thread, the caller sees the result without waiting for the thread pool
+            this.SetOutcome(exception, result);
+        }
+        else
+        {
+            Task.Run(() => this.SetOutcome(exception, result));
+        }
+    }
+
+    void SetOutcome(object exception, object result)
+    {
+        if (exception != null)
+        {
+            var e = exception as Exception;
+            var s = exception as string;
+            if (e != null)
+            {
+                this.TaskCompletionSource.SetException(e);
+            }
+            else if (!string.IsNullOrEmpty(s))
             {
-                var e = exception as Exception;
-                var s = exception as string;
-                if (e != null)
-                {
-                    this.TaskCompletionSource.SetException(e);
-                }
-                else if (!string.IsNullOrEmpty(s))
-                {
-                    this.TaskCompletionSource.SetException(new Exception(s));
-                }
-                else
-                {
-                    this.TaskCompletionSource.SetException(
-                        new InvalidOperationException("Unrecognized exception received from JavaScript."));
-                }
+                this.TaskCompletionSource.SetException(new Exception(s));
             }
             else
             {
-                this.TaskCompletionSource.SetResult(result);
+                this.TaskCompletionSource.SetException(
+                    new InvalidOperationException("Unrecognized exception received from JavaScript."));
             }
-        });
+        }
+        else
+        {
+            this.TaskCompletionSource.SetResult(result);
+        }
     }
 };
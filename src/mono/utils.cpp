@@ -11,8 +11,10 @@ v8::Local<v8::String> stringCLR2V8(MonoString* text)
 MonoString* stringV82CLR(v8::Handle<v8::String> text)
 {
     Nan::HandleScope scope;
-    v8::String::Utf8Value utf8text(text);
-    return mono_string_new(mono_domain_get(), *utf8text);    
+    int length = text->Length();
+    MonoString* result = mono_string_new_size(mono_domain_get(), length);
+    text->Write((uint16_t*)mono_string_chars(result), 0, length, v8::String::NO_NULL_TERMINATION);
+    return result;
 }
 
 MonoString* exceptionV82stringCLR(v8::Handle<v8::Value> exception)
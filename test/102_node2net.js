@@ -162,6 +162,141 @@ describe('async call from node.js to .net', function () {
         })
     });
 
+    it('successfuly roundtrips nested data', function (done) {
+        var func = edge.func({
+        	assemblyFile: edgeTestDll,
+        	typeName: 'Edge.Tests.Startup',
+        	methodName: 'ReturnInput'
+        });
+
+        var k = {
+            a: [1, 'two', [3.5, null, true], { b: new Buffer([1, 2, 3]) }],
+            c: { d: { e: 'ñòó', f: -4 } },
+            g: []
+        };
+        func(k, function (error, result) {
+            assert.ifError(error);
+            assert.deepEqual(result, k);
+            done();
+        })
+    });
+
+    it('successfuly roundtrips one-byte and two-byte strings', function (done) {
+        var func = edge.func({
+        	assemblyFile: edgeTestDll,
+        	typeName: 'Edge.Tests.Startup',
+        	methodName: 'ReturnInput'
+        });
+
+        var k = { 'ñòó': 'ÿ\u0000x', 'żółw': 'Ωμέγα \ud83d\ude00' };
+        func(k, function (error, result) {
+            assert.ifError(error);
+            assert.deepEqual(result, k);
+            done();
+        })
+    });
+
+    it('successfuly marshals typed arrays', function (done) {
+        var func = edge.func({
+        	assemblyFile: edgeTestDll,
+        	typeName: 'Edge.Tests.Startup',
+        	methodName: 'DescribeTypedArrays'
+        });
+
+        var k = {
+            a: new Float64Array([1.5, -2.5]),
+            b: new Int32Array([1, -2, 3]),
+            c: new Uint16Array([65535]),
+            d: new Int8Array(new Int8Array([9, -1, 2, 7]).buffer, 1, 2)
+        };
+        func(k, function (error, result) {
+            assert.ifError(error);
+            assert.equal(result, 'a:Double[]:-1 b:Int32[]:2 c:UInt16[]:65535 d:SByte[]:1');
+            done();
+        })
+    });
+
+    if (process.env.EDGE_USE_CORECLR && process.env.EDGE_MARSHAL_PACKED_ARRAYS) {
+        it('successfuly marshals homogeneous arrays as primitive arrays', function (done) {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'DescribeArrayTypes'
+            });
+
+            var k = { a: [1, 2, 3], b: [1, 2.5], c: [true, false], d: ['x', 'y'], e: [1, 'x'], f: [] };
+            func(k, function (error, result) {
+                assert.ifError(error);
+                assert.equal(result, 'a:Int32[] b:Double[] c:Boolean[] d:String[] e:Object[] f:Object[]');
+                done();
+            })
+        });
+    }
+
+    if (process.env.EDGE_USE_CORECLR) {
+        it('successfuly binds object to typed parameter', function (done) {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'DescribeTypedPayload'
+            });
+
+            var k = {
+                id: 12,
+                customer: 'foo',
+                total: 3.5,
+                priority: 2,
+                rush: true,
+                lines: [{ sku: 'a', quantity: 1 }, { sku: 'b', quantity: 2 }],
+                tags: ['x', 'y'],
+                ignored: { a: 1 }
+            };
+            func(k, function (error, result) {
+                assert.ifError(error);
+                assert.equal(result, '12:foo:3.5:2:True:ax1,bx2:x,y');
+                done();
+            })
+        });
+
+        it('successfuly binds object to dictionary parameter', function (done) {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'DescribeDictionaryPayload'
+            });
+
+            func({ a: 'foo', b: 1 }, function (error, result) {
+                assert.ifError(error);
+                assert.equal(result, 'Dictionary`2:2:foo');
+                done();
+            })
+        });
+    }
+
+    it('successfuly marshals own properties of objects of the same shape', function (done) {
+        var func = edge.func({
+        	assemblyFile: edgeTestDll,
+        	typeName: 'Edge.Tests.Startup',
+        	methodName: 'ReturnInput'
+        });
+
+        var base = { inherited: 1 };
+        var k = [1, 2, 3].map(function (i) {
+            var item = Object.create(base);
+            item.id = i;
+            item.name = 'item' + i;
+            item[7] = i;
+            return item;
+        });
+        func(k, function (error, result) {
+            assert.ifError(error);
+            assert.deepEqual(result, [1, 2, 3].map(function (i) {
+                return { id: i, name: 'item' + i, 7: i };
+            }));
+            done();
+        })
+    });
+
     it('successfuly roundtrips empty string', function (done) {
         var func = edge.func({
         	assemblyFile: edgeTestDll,
@@ -177,6 +312,36 @@ describe('async call from node.js to .net', function () {
         })
     });
 
+    it('successfuly roundtrips scalar values', function (done) {
+        var func = edge.func({
+        	assemblyFile: edgeTestDll,
+        	typeName: 'Edge.Tests.Startup',
+        	methodName: 'ReturnInput'
+        });
+        var offloaded = edge.func({
+        	assemblyFile: edgeTestDll,
+        	typeName: 'Edge.Tests.Startup',
+        	methodName: 'ReturnInput',
+        	offload: true
+        });
+
+        assert.strictEqual(func(7, true), 7);
+        assert.strictEqual(func(-3.25, true), -3.25);
+        assert.strictEqual(func(true, true), true);
+        assert.strictEqual(func(false, true), false);
+        assert.strictEqual(func(null, true), null);
+        assert.strictEqual(func(undefined, true), null);
+        offloaded(2.5, function (error, result) {
+            assert.ifError(error);
+            assert.strictEqual(result, 2.5);
+            func(-7, function (error, result) {
+                assert.ifError(error);
+                assert.strictEqual(result, -7);
+                done();
+            });
+        });
+    });
+
     // Note: This doesn't seem to be sufficient to force the repro of the hang,
     // but it's a good test to make sure works.
     it('successfuly handles process.nextTick in the callback', function (done) {
@@ -195,4 +360,277 @@ describe('async call from node.js to .net', function () {
             });
         })
     });
+
+    it('succeeds for offloaded call', function (done) {
+        var onV8Thread = edge.func({
+            assemblyFile: edgeTestDll,
+            typeName: 'Edge.Tests.Startup',
+            methodName: 'CurrentThreadId'
+        });
+        var offloaded = edge.func({
+            assemblyFile: edgeTestDll,
+            typeName: 'Edge.Tests.Startup',
+            methodName: 'CurrentThreadId',
+            offload: true
+        });
+
+        var v8ThreadId = onV8Thread(null, true);
+        offloaded(null, function (error, result) {
+            assert.ifError(error);
+            assert.equal(typeof result, 'number');
+            assert.notEqual(result, v8ThreadId);
+            done();
+        });
+    });
+
+    it('runs offloaded function in place when called synchronously', function () {
+        var func = edge.func({
+            assemblyFile: edgeTestDll,
+            typeName: 'Edge.Tests.Startup',
+            methodName: 'Invoke',
+            offload: true
+        });
+
+        assert.equal(func('Node.js', true), '.NET welcomes Node.js');
+    });
+
+    it('successfuly calls static method', function (done) {
+        var func = edge.func({
+            assemblyFile: edgeTestDll,
+            typeName: 'Edge.Tests.Startup',
+            methodName: 'StaticInvoke'
+        });
+
+        func('Node.js', function (error, result) {
+            assert.ifError(error);
+            assert.equal(result, '.NET static welcomes Node.js');
+            done();
+        });
+    });
+
+    it('fails to call disposed function', function () {
+        var func = edge.func({
+            assemblyFile: edgeTestDll,
+            typeName: 'Edge.Tests.Startup',
+            methodName: 'Invoke'
+        });
+
+        assert.equal(func('Node.js', true), '.NET welcomes Node.js');
+        func.dispose();
+        assert.throws(function () {
+            func('Node.js', true);
+        }, /The CLR function has been disposed/);
+    });
+
+    if (process.env.EDGE_USE_CORECLR || process.platform !== 'win32') {
+        it('releases CLR handle of disposed function', function () {
+            var liveClrHandles = edge.stats().liveClrHandles;
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'Invoke'
+            });
+
+            assert.equal(edge.stats().liveClrHandles, liveClrHandles + 1);
+            func.dispose();
+            func.dispose();
+            assert.equal(edge.stats().liveClrHandles, liveClrHandles);
+        });
+
+        it('returns promise resolved with result of call without callback', function () {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'Invoke',
+                promise: true
+            });
+
+            var result = func('Node.js');
+            assert.ok(result instanceof Promise);
+            return result.then(function (result) {
+                assert.equal(result, '.NET welcomes Node.js');
+            });
+        });
+
+        it('returns promise resolved with result of asynchronous call', function () {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'ReturnInput',
+                offload: true,
+                promise: true
+            });
+
+            return func({ a: 1 }).then(function (result) {
+                assert.deepEqual(result, { a: 1 });
+            });
+        });
+
+        it('returns promise rejected with .net exception', function () {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'NetExceptionCLRThread',
+                promise: true
+            });
+
+            return func(null).then(function () {
+                assert.fail('promise was not rejected');
+            }, function (error) {
+                assert.ok(error instanceof Error);
+                assert.ok(error.message.indexOf('Test .NET exception') > -1);
+            });
+        });
+
+        it('completes calls without callback or promise', function (done) {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'AddSevenAsync'
+            });
+            var offloaded = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'AddSevenAsync',
+                offload: true
+            });
+
+            assert.equal(func(3), undefined);
+            assert.equal(offloaded(3), undefined);
+            setTimeout(done, 50);
+        });
+
+        it('supports callback and synchronous calls of function returning promises', function (done) {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'Invoke',
+                promise: true
+            });
+
+            assert.equal(func('Node.js', true), '.NET welcomes Node.js');
+            assert.equal(func('Node.js', function (error, result) {
+                assert.ifError(error);
+                assert.equal(result, '.NET welcomes Node.js');
+                done();
+            }), undefined);
+        });
+    }
+
+    if (process.env.EDGE_USE_CORECLR || process.platform !== 'win32') {
+        it('passes buffer as a view with zeroCopyBuffers', function () {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'IncrementBufferInPlace',
+                zeroCopyBuffers: true
+            });
+
+            var buffer = new Buffer([1, 2, 3]);
+            assert.equal(func(buffer, true), 3);
+            assert.deepEqual(Array.prototype.slice.call(buffer), [2, 3, 4]);
+        });
+
+        it('passes buffer as a view with zeroCopyBuffers to an async call', function (done) {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'SumBufferStream',
+                zeroCopyBuffers: true,
+                offload: true
+            });
+
+            func(new Buffer([1, 2, 3]), function (error, result) {
+                assert.ifError(error);
+                assert.equal(result, 6);
+                done();
+            });
+        });
+
+        it('detaches large buffer with transferBuffers', function () {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'SumBufferStream',
+                transferBuffers: true
+            });
+
+            var buffer = Buffer.alloc(65536, 1);
+            assert.equal(func(buffer, true), 65536);
+            assert.equal(buffer.length, 0);
+        });
+
+        it('copies pooled buffer with transferBuffers', function () {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'SumBufferStream',
+                transferBuffers: true
+            });
+
+            var buffer = Buffer.from([1, 2, 3]);
+            assert.equal(func(buffer, true), 6);
+            assert.equal(buffer.length, 3);
+        });
+
+        it('successfuly calls method returning Task<int>', function (done) {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'AddSevenAsync'
+            });
+
+            func(3, function (error, result) {
+                assert.ifError(error);
+                assert.equal(result, 10);
+                done();
+            });
+        });
+
+        it('successfuly passes null to method taking int', function (done) {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'AddSevenAsync'
+            });
+
+            func(null, function (error, result) {
+                assert.ifError(error);
+                assert.equal(result, 7);
+                done();
+            });
+        });
+
+        it('successfuly calls synchronous method returning int', function () {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'AddSeven'
+            });
+
+            assert.equal(func(3, true), 10);
+        });
+
+        it('successfuly calls synchronous method taking IDictionary<string, object>', function () {
+            var func = edge.func({
+                assemblyFile: edgeTestDll,
+                typeName: 'Edge.Tests.Startup',
+                methodName: 'CountProperties'
+            });
+
+            assert.equal(func({ a: 1, b: 'x', c: [] }, true), 3);
+        });
+
+        if (process.env.EDGE_USE_CORECLR) {
+            it('successfuly calls synchronous method taking a class', function () {
+                var func = edge.func({
+                    assemblyFile: edgeTestDll,
+                    typeName: 'Edge.Tests.Startup',
+                    methodName: 'DescribeOrderLine'
+                });
+
+                assert.equal(func({ sku: 'a', quantity: 2 }, true), 'ax2');
+            });
+        }
+    }
 });
\ No newline at end of file
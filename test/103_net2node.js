@@ -93,6 +93,22 @@ describe('async call from .net to node.js', function () {
 		});
 	});
 
+	it('successfuly marshals list of objects of the same type from .net to node.js', function (done) {
+		var func = edge.func({
+			assemblyFile: edgeTestDll,
+			typeName: 'Edge.Tests.Startup',
+			methodName: 'MarshalObjectList'
+		});
+		func(3, function (error, result) {
+			assert.ifError(error);
+			assert.equal(result.length, 3);
+			for (var i = 0; i < result.length; i++) {
+				assert.deepEqual(result[i], { B_prop: 'p' + i, A_prop: null, B_field: 'b' + i, A_field: 'a' + i });
+			}
+			done();
+		});
+	});
+
 	it('successfuly marshals data from node.js to .net', function (done) {
 		var func = edge.func({
 			assemblyFile: edgeTestDll,
@@ -183,6 +199,155 @@ describe('async call from .net to node.js', function () {
 		});
 	});
 
+	if (process.env.EDGE_USE_CORECLR || process.platform !== 'win32') {
+		it('succeeds for function returning a value', function (done) {
+			var func = edge.func({
+				assemblyFile: edgeTestDll,
+				typeName: 'Edge.Tests.Startup',
+				methodName: 'InvokeBack'
+			});
+			var payload = {
+				hello: function (payload) {
+					return 'Node.js welcomes ' + payload;
+				}
+			};
+			func(payload, function (error, result) {
+				assert.ifError(error);
+				assert.equal(result, 'Node.js welcomes .NET');
+				done();
+			});
+		});
+
+		it('succeeds for function returning a promise', function (done) {
+			var func = edge.func({
+				assemblyFile: edgeTestDll,
+				typeName: 'Edge.Tests.Startup',
+				methodName: 'InvokeBack'
+			});
+			var payload = {
+				hello: function (payload) {
+					return new Promise(function (resolve) {
+						setImmediate(function () {
+							resolve('Node.js welcomes ' + payload);
+						});
+					});
+				}
+			};
+			func(payload, function (error, result) {
+				assert.ifError(error);
+				assert.equal(result, 'Node.js welcomes .NET');
+				done();
+			});
+		});
+
+		it('successfuly marshals rejection of returned promise', function (done) {
+			var func = edge.func({
+				assemblyFile: edgeTestDll,
+				typeName: 'Edge.Tests.Startup',
+				methodName: 'MarshalException'
+			});
+			var payload = {
+				hello: function (result) {
+					return Promise.reject(new Error('Sample Node.js exception'));
+				}
+			};
+			func(payload, function (error, result) {
+				assert.ifError(error);
+				assert.equal(typeof result, 'string');
+				assert.ok(result.indexOf('Sample Node.js exception') > 0);
+				done();
+			});
+		});
+
+		it('ignores callback called again after its call completed', function (done) {
+			var func = edge.func({
+				assemblyFile: edgeTestDll,
+				typeName: 'Edge.Tests.Startup',
+				methodName: 'InvokeBack'
+			});
+			var lateCallback;
+			var first = {
+				hello: function (payload, callback) {
+					lateCallback = callback;
+					callback(null, 'first');
+				}
+			};
+			var second = {
+				hello: function (payload, callback) {
+					setImmediate(function () {
+						lateCallback(null, 'late');
+						setTimeout(function () {
+							callback(null, 'second');
+						}, 10);
+					});
+				}
+			};
+			func(first, function (error, result) {
+				assert.ifError(error);
+				assert.equal(result, 'first');
+				func(second, function (error, result) {
+					assert.ifError(error);
+					assert.equal(result, 'second');
+					done();
+				});
+			});
+		});
+
+		it('ignores return value of function taking a callback', function (done) {
+			var func = edge.func({
+				assemblyFile: edgeTestDll,
+				typeName: 'Edge.Tests.Startup',
+				methodName: 'InvokeBack'
+			});
+			var payload = {
+				hello: function (payload, callback) {
+					setImmediate(function () {
+						callback(null, 'Node.js welcomes ' + payload);
+					});
+					return 'ignored';
+				}
+			};
+			func(payload, function (error, result) {
+				assert.ifError(error);
+				assert.equal(result, 'Node.js welcomes .NET');
+				done();
+			});
+		});
+	}
+
+	if (process.env.EDGE_USE_CORECLR || process.platform !== 'win32') {
+		it('calls node.js function inline from synchronous .net call', function () {
+			var func = edge.func({
+				assemblyFile: edgeTestDll,
+				typeName: 'Edge.Tests.Startup',
+				methodName: 'InvokeBack'
+			});
+			var payload = {
+				hello: function (payload, callback) {
+					callback(null, 'Node.js welcomes ' + payload);
+				}
+			};
+			var result = func(payload, true);
+			assert.equal(result, 'Node.js welcomes .NET');
+		});
+
+		it('successfuly marshals v8 exception thrown inline from synchronous .net call', function () {
+			var func = edge.func({
+				assemblyFile: edgeTestDll,
+				typeName: 'Edge.Tests.Startup',
+				methodName: 'MarshalException'
+			});
+			var payload = {
+				hello: function (result, callback) {
+					throw new Error('Sample Node.js exception');
+				}
+			};
+			var result = func(payload, true);
+			assert.equal(typeof result, 'string');
+			assert.ok(result.indexOf('Sample Node.js exception') > 0);
+		});
+	}
+
 	it('successfuly marshals empty buffer', function (done) {
 		var func = edge.func({
 			assemblyFile: edgeTestDll,
@@ -197,6 +362,101 @@ describe('async call from .net to node.js', function () {
 			done();
 		})
 	});
+
+	it('successfuly marshals large buffer', function (done) {
+		var func = edge.func({
+			assemblyFile: edgeTestDll,
+			typeName: 'Edge.Tests.Startup',
+			methodName: 'ReturnLargeBuffer'
+		});
+
+		func(65536, function (error, result) {
+			assert.ifError(error);
+			assert.ok(Buffer.isBuffer(result));
+			assert.equal(result.length, 65536);
+			for (var i = 0; i < result.length; i += 1021) {
+				assert.equal(result[i], i % 256);
+			}
+			done();
+		})
+	});
+
+	if (process.env.EDGE_MARSHAL_ARRAY_AS_TYPED_ARRAY) {
+		it('successfuly marshals primitive arrays as typed arrays', function (done) {
+			var func = edge.func({
+				assemblyFile: edgeTestDll,
+				typeName: 'Edge.Tests.Startup',
+				methodName: 'ReturnPrimitiveArrays'
+			});
+
+			func(null, function (error, result) {
+				assert.ifError(error);
+				assert.ok(result.a instanceof Float64Array);
+				assert.deepEqual(Array.prototype.slice.call(result.a), [1.5, -2.5]);
+				assert.ok(result.b instanceof Int32Array);
+				assert.deepEqual(Array.prototype.slice.call(result.b), [1, -2, 3]);
+				assert.ok(result.c instanceof Uint16Array);
+				assert.deepEqual(Array.prototype.slice.call(result.c), [65535]);
+				done();
+			})
+		});
+	}
+
+	it('successfuly marshals homogeneous arrays', function (done) {
+		var func = edge.func({
+			assemblyFile: edgeTestDll,
+			typeName: 'Edge.Tests.Startup',
+			methodName: 'ReturnHomogeneousArrays'
+		});
+
+		func(null, function (error, result) {
+			assert.ifError(error);
+			assert.deepEqual(result, {
+				a: [1, -2, 3],
+				b: [1.5, -2.5],
+				c: [true, false],
+				d: ['x', '\u0105'],
+				e: ['x', null]
+			});
+			assert.ok(Array.isArray(result.a));
+			done();
+		})
+	});
+
+	it('successfuly marshals large string', function (done) {
+		var func = edge.func({
+			assemblyFile: edgeTestDll,
+			typeName: 'Edge.Tests.Startup',
+			methodName: 'ReturnLargeString'
+		});
+
+		func(100000, function (error, result) {
+			assert.ifError(error);
+			assert.equal(typeof result, 'string');
+			assert.equal(result.length, 100000);
+			assert.equal(result, new Array(100001).join('\u0105'));
+			done();
+		})
+	});
+
+	if (process.env.EDGE_USE_CORECLR) {
+		it('successfuly marshals large array segment', function (done) {
+			var func = edge.func({
+				assemblyFile: edgeTestDll,
+				typeName: 'Edge.Tests.Startup',
+				methodName: 'ReturnLargeBufferSegment'
+			});
+
+			func(65536, function (error, result) {
+				assert.ifError(error);
+				assert.ok(Buffer.isBuffer(result));
+				assert.equal(result.length, 65536 - 32);
+				assert.equal(result[0], 16);
+				assert.equal(result[result.length - 1], (65536 - 17) % 256);
+				done();
+			})
+		});
+	}
 });
 
 describe('delayed call from node.js to .net', function () {
@@ -246,4 +506,30 @@ describe('delayed call from node.js to .net', function () {
 			trace.push('InvokeBackAfterCLRCallHasFinished#ReturnedToNode');
 		});
 	});
+
+	if (process.env.EDGE_USE_CORECLR || process.platform !== 'win32') {
+		it('releases node.js functions collected by .NET', function (done) {
+			var collectGarbage = edge.func({
+				assemblyFile: edgeTestDll,
+				typeName: 'Edge.Tests.Startup',
+				methodName: 'CollectGarbage'
+			});
+
+			var callbacks = [];
+			for (var i = 0; i < 100; i++) {
+				callbacks.push(function () {});
+			}
+
+			var liveNodejsFuncs = edge.stats().liveNodejsFuncs;
+			collectGarbage({ callbacks: callbacks }, true);
+			assert.ok(edge.stats().liveNodejsFuncs >= liveNodejsFuncs + 100);
+			collectGarbage(null, true);
+
+			// Functions collected by .NET are released on the next turn of the event loop
+			setTimeout(function () {
+				assert.ok(edge.stats().liveNodejsFuncs <= liveNodejsFuncs);
+				done();
+			}, 100);
+		});
+	}
 });
\ No newline at end of file
@@ -265,6 +265,14 @@ namespace Edge.Tests
             return result.Task;
         }
 
+        public Task<object> CollectGarbage(dynamic input)
+        {
+            GC.Collect();
+            GC.WaitForPendingFinalizers();
+
+            return Task.FromResult<object>(null);
+        }
+
         public async Task<object> MarshalObjectHierarchy(dynamic input)
         {
             var result = new B();
@@ -276,6 +284,17 @@ namespace Edge.Tests
             return result;
         }
 
+        public async Task<object> MarshalObjectList(dynamic input)
+        {
+            var result = new List<B>();
+            for (int i = 0; i < (int)input; i++)
+            {
+                result.Add(new B { A_field = "a" + i, A_prop = null, B_field = "b" + i, B_prop = "p" + i });
+            }
+
+            return result;
+        }
+
         public Task<object> NetStructuredExceptionCLRThread(dynamic input)
         {
             Task<object> task = Task.Delay(200).ContinueWith(new Func<Task, object>((antecedant) =>
@@ -298,11 +317,162 @@ namespace Edge.Tests
             return new byte[] {};
         }
 
+        public async Task<object> ReturnLargeBuffer(dynamic input)
+        {
+            byte[] buffer = new byte[(int)input];
+            for (int i = 0; i < buffer.Length; i++)
+            {
+                buffer[i] = (byte)i;
+            }
+
+            return buffer;
+        }
+
+        public async Task<object> ReturnLargeBufferSegment(dynamic input)
+        {
+            byte[] buffer = (byte[])(await ReturnLargeBuffer(input));
+            return new ArraySegment<byte>(buffer, 16, buffer.Length - 32);
+        }
+
+        public async Task<object> ReturnLargeString(dynamic input)
+        {
+            return new string('\u0105', (int)input);
+        }
+
         public async Task<object> ReturnInput(dynamic input)
         {
             return input;
         }
 
+        public async Task<object> IncrementBufferInPlace(dynamic input)
+        {
+            Stream stream = (Stream)input;
+            byte[] data = new byte[stream.Length];
+            stream.Read(data, 0, data.Length);
+            for (int i = 0; i < data.Length; i++)
+            {
+                data[i]++;
+            }
+
+            stream.Position = 0;
+            stream.Write(data, 0, data.Length);
+            return data.Length;
+        }
+
+        public async Task<object> SumBufferStream(dynamic input)
+        {
+            using (Stream stream = (Stream)input)
+            {
+                int sum = 0;
+                int b;
+                while ((b = stream.ReadByte()) != -1)
+                {
+                    sum += b;
+                }
+
+                return sum;
+            }
+        }
+
+        public async Task<object> DescribeTypedArrays(dynamic input)
+        {
+            IDictionary<string, object> arrays = (IDictionary<string, object>)input;
+            List<string> result = new List<string>();
+            foreach (KeyValuePair<string, object> array in arrays)
+            {
+                double sum = 0;
+                foreach (object item in (Array)array.Value)
+                {
+                    sum += Convert.ToDouble(item);
+                }
+
+                result.Add(array.Key + ":" + array.Value.GetType().Name + ":" + sum);
+            }
+
+            return string.Join(" ", result);
+        }
+
+        public async Task<object> ReturnPrimitiveArrays(dynamic input)
+        {
+            return new
+            {
+                a = new double[] { 1.5, -2.5 },
+                b = new int[] { 1, -2, 3 },
+                c = new ushort[] { 65535 }
+            };
+        }
+
+        public async Task<object> DescribeArrayTypes(dynamic input)
+        {
+            List<string> result = new List<string>();
+            foreach (KeyValuePair<string, object> array in (IDictionary<string, object>)input)
+            {
+                result.Add(array.Key + ":" + array.Value.GetType().Name);
+            }
+
+            return string.Join(" ", result);
+        }
+
+        public async Task<object> DescribeTypedPayload(Order input)
+        {
+            List<string> lines = new List<string>();
+            foreach (OrderLine line in input.Lines)
+            {
+                lines.Add(line.Sku + "x" + line.Quantity);
+            }
+
+            return input.Id + ":" + input.Customer + ":" + input.Total + ":" + input.Priority + ":" + input.Rush + ":" +
+                string.Join(",", lines) + ":" + string.Join(",", input.Tags);
+        }
+
+        public async Task<object> DescribeDictionaryPayload(IDictionary<string, object> input)
+        {
+            return input.GetType().Name + ":" + input.Count + ":" + input["a"];
+        }
+
+        public static async Task<object> StaticInvoke(dynamic input)
+        {
+            return ".NET static welcomes " + input;
+        }
+
+        public async Task<int> AddSevenAsync(int input)
+        {
+            await Task.Delay(1);
+            return input + 7;
+        }
+
+        public int AddSeven(int input)
+        {
+            return input + 7;
+        }
+
+        public int CountProperties(IDictionary<string, object> input)
+        {
+            return input.Count;
+        }
+
+        public string DescribeOrderLine(OrderLine input)
+        {
+            return input.Sku + "x" + input.Quantity;
+        }
+
+        public async Task<object> ReturnHomogeneousArrays(dynamic input)
+        {
+            return new
+            {
+                a = new List<int> { 1, -2, 3 },
+                b = new double[] { 1.5, -2.5 },
+                c = new bool[] { true, false },
+                d = new List<string> { "x", "\u0105" },
+                e = new string[] { "x", null }
+            };
+        }
+
+        public Task<object> CurrentThreadId(dynamic input)
+        {
+            return Task.FromResult((object)Environment.CurrentManagedThreadId);
+        }
+
         public async Task<object> ReturnLambdaWithClosureOverState(dynamic input)
         {
             var k = (int)input;
@@ -412,6 +582,23 @@ namespace Edge.Tests
         }
 #endif
 
+        public class Order
+        {
+            public int Id { get; set; }
+            public string Customer { get; set; }
+            public double Total { get; set; }
+            public long Priority;
+            public bool Rush;
+            public List<OrderLine> Lines { get; set; }
+            public string[] Tags { get; set; }
+        }
+
+        public class OrderLine
+        {
+            public string Sku { get; set; }
+            public int Quantity { get; set; }
+        }
+
         public class BadPerson 
         {
             public string Name 